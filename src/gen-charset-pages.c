@@ -0,0 +1,219 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/*
+ * gen-charset-pages.c
+ * This file is part of the libhwp project.
+ *
+ * Copyright (C) 2016 Hodong Kim <cogniti@gmail.com>
+ *
+ * The libhwp is dual licensed under the LGPL v3+ or Apache License 2.0
+ *
+ * The libhwp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The libhwp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program;  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Or,
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Prints hwp-charset-pages.h: the hnc and hypua tables of
+ * hwp-charset-tables.h as a compact two-level page table, compiled into
+ * libhwp only.  The output is kept in git; this is a maintainer tool, run
+ * by "make update-charset-pages" after the tables change.  It uses only
+ * the type names of glib.h, so it needs no library to link against.
+ *
+ * A character code is split into a page number (code >> 6) and an index
+ * in the page (code & 63).  The first level maps a page number to a page;
+ * identical pages, e.g. runs of unmapped codes, are stored once.  A page
+ * is a run of UTF-16 code units in charset_units, starting at its base,
+ * and 65 8-bit offsets into that run: the conversion of index i is the
+ * code units from offsets[i] up to offsets[i + 1], at most 3 of them, so
+ * the offsets of a 64-code page never exceed 192.
+ *
+ * UTF-16 is kept rather than UTF-8 because most hnc Hangul codes map to
+ * three conjoining jamo: 6 bytes of UTF-16 but 9 of UTF-8.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <glib.h>
+
+#include "hwp-charset-tables.h"
+
+#define PAGE_BITS   6
+#define PAGE_SIZE   (1 << PAGE_BITS)
+#define HYPUA_FIRST 0xe0bc
+#define HYPUA_LAST  0xf8f7
+
+typedef struct
+{
+  guint8    offsets[PAGE_SIZE + 1];
+  gunichar2 units[PAGE_SIZE * 3];
+} Page;
+
+#define N_HNC_PAGES (0x10000 >> PAGE_BITS)
+#define N_HYC_PAGES ((HYPUA_LAST >> PAGE_BITS) - (HYPUA_FIRST >> PAGE_BITS) + 1)
+
+static Page    pages[N_HNC_PAGES + N_HYC_PAGES];
+static guint   n_pages;
+static guint16 hnc_page[N_HNC_PAGES];
+static guint16 hyc_page[N_HYC_PAGES];
+
+static guint put_unichar (gunichar2 *out, gunichar c)
+{
+  if (c < 0x10000)
+  {
+    out[0] = c;
+    return 1;
+  }
+
+  c -= 0x10000;
+  out[0] = 0xd800 + (c >> 10);
+  out[1] = 0xdc00 + (c & 0x3ff);
+  return 2;
+}
+
+/* NUL 은 문자열에 들어가지 않으므로 건너뛴다 */
+static guint put_chars (gunichar2 *out, const gunichar2 *chars, guint n)
+{
+  guint len = 0;
+
+  for (guint i = 0; i < n && chars[i]; i++)
+    out[len++] = chars[i];
+
+  return len;
+}
+
+/* same mapping as hwp_hnchar_to_utf8() had with the tables */
+static guint hnchar_to_units (guint16 c, gunichar2 *out)
+{
+  gunichar2 c2;
+
+  if (c >= 0x0020 && c <= 0x007e)
+    return put_unichar (out, c);
+  else if (c >= 0x007f && c <= 0x3fff)
+    return hnc2uni_page0[c] ? put_unichar (out, hnc2uni_page0[c]) : 0;
+  else if (c >= 0x4000 && c <= 0x5317)
+    return (c2 = hnc2uni_page4[c-0x4000]) ? put_unichar (out, c2) : 0;
+  else if (c >= 0x5318 && c <= 0x7fff)
+    return hnc2uni_page5[c-0x5318] ? put_unichar (out, hnc2uni_page5[c-0x5318]) : 0;
+  else if (c >= 0x8000)
+    return put_chars (out, hnc2uni_page8[c-0x8000], 3);
+
+  return 0;
+}
+
+static guint hychar_to_units (guint16 c, gunichar2 *out)
+{
+  if (c >= HYPUA_FIRST && c <= HYPUA_LAST)
+    return put_chars (out, hyc2uni_page14[c - HYPUA_FIRST], 3);
+
+  return 0;
+}
+
+/* builds page @number with @func and returns its index, sharing an
+ * identical page built before */
+static guint16 add_page (guint number, guint (*func) (guint16, gunichar2 *))
+{
+  Page *page = &pages[n_pages];
+  guint len  = 0;
+
+  for (guint i = 0; i < PAGE_SIZE; i++)
+  {
+    page->offsets[i] = len;
+    len += func ((number << PAGE_BITS) | i, page->units + len);
+    assert (len <= PAGE_SIZE * 3);
+  }
+  page->offsets[PAGE_SIZE] = len;
+
+  for (guint i = 0; i < n_pages; i++)
+  {
+    if (memcmp (pages[i].offsets, page->offsets, sizeof page->offsets) == 0 &&
+        memcmp (pages[i].units, page->units, len * sizeof (gunichar2)) == 0)
+      return i;
+  }
+
+  return n_pages++;
+}
+
+static void print_guint16s (const gchar *name, const guint16 *v, guint n)
+{
+  printf ("static const guint16 %s[%u] = {", name, n);
+  for (guint i = 0; i < n; i++)
+    printf ("%s%u,", i % 12 ? " " : "\n  ", v[i]);
+  printf ("\n};\n\n");
+}
+
+int main (void)
+{
+  guint32 base = 0;
+
+  for (guint i = 0; i < N_HNC_PAGES; i++)
+    hnc_page[i] = add_page (i, hnchar_to_units);
+
+  for (guint i = 0; i < N_HYC_PAGES; i++)
+    hyc_page[i] = add_page ((HYPUA_FIRST >> PAGE_BITS) + i, hychar_to_units);
+
+  printf ("/* hwp-charset-pages.h: generated by gen-charset-pages from "
+          "hwp-charset-tables.h, do not edit */\n\n");
+  printf ("#ifndef __HWP_CHARSET_PAGES_H__\n"
+          "#define __HWP_CHARSET_PAGES_H__\n\n"
+          "#include <glib.h>\n\n");
+  printf ("#define CHARSET_PAGE_BITS   %u\n", PAGE_BITS);
+  printf ("#define HYC_FIRST_PAGE      0x%x\n\n", HYPUA_FIRST >> PAGE_BITS);
+
+  print_guint16s ("hnc_page", hnc_page, N_HNC_PAGES);
+  print_guint16s ("hyc_page", hyc_page, N_HYC_PAGES);
+
+  printf ("static const guint32 charset_page_base[%u] = {", n_pages);
+  for (guint i = 0; i < n_pages; i++)
+  {
+    printf ("%s%u,", i % 8 ? " " : "\n  ", base);
+    base += pages[i].offsets[PAGE_SIZE];
+  }
+  printf ("\n};\n\n");
+
+  printf ("static const guint8 charset_page_offsets[%u][%u] = {\n",
+          n_pages, PAGE_SIZE + 1);
+  for (guint i = 0; i < n_pages; i++)
+  {
+    printf ("  {");
+    for (guint j = 0; j <= PAGE_SIZE; j++)
+      printf ("%s%u,", j % 16 ? " " : "\n    ", pages[i].offsets[j]);
+    printf ("\n  },\n");
+  }
+  printf ("};\n\n");
+
+  printf ("static const guint16 charset_units[%u] = {", base);
+  for (guint i = 0, k = 0; i < n_pages; i++)
+  {
+    for (guint j = 0; j < pages[i].offsets[PAGE_SIZE]; j++, k++)
+      printf ("%s0x%04x,", k % 10 ? " " : "\n  ", pages[i].units[j]);
+  }
+  printf ("\n};\n\n");
+
+  printf ("#endif /* __HWP_CHARSET_PAGES_H__ */\n");
+
+  return 0;
+}
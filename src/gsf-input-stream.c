@@ -66,6 +66,28 @@ gssize gsf_input_stream_read (GInputStream *base,
   return (gssize) (remaining - gsf_input_remaining (gis->priv->input));
 }
 
+gssize gsf_input_stream_skip (GInputStream *base,
+                              gsize         count,
+                              GCancellable *cancellable,
+                              GError      **error)
+{
+  GsfInputStream *gis = GSF_INPUT_STREAM (base);
+  gint64    remaining = gsf_input_remaining (gis->priv->input);
+
+  if ((gint64) count > remaining)
+    count = (gsize) remaining;
+
+  /* no copy, only the position of the input moves */
+  if (gsf_input_seek (gis->priv->input, (gsf_off_t) count, G_SEEK_CUR))
+  {
+    g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                         "gsf_input_seek failed");
+    return -1;
+  }
+
+  return (gssize) count;
+}
+
 gboolean gsf_input_stream_close (GInputStream *base,
                                  GCancellable *cancellable,
                                  GError      **error)
@@ -95,6 +117,7 @@ static void gsf_input_stream_class_init (GsfInputStreamClass *klass)
   GInputStreamClass *parent_class = G_INPUT_STREAM_CLASS (klass);
   g_type_class_add_private (klass, sizeof (GsfInputStreamPrivate));
   parent_class->read_fn  = gsf_input_stream_read;
+  parent_class->skip     = gsf_input_stream_skip;
   parent_class->close_fn = gsf_input_stream_close;
   object_class->finalize = gsf_input_stream_finalize;
 }
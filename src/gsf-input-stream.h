@@ -40,6 +40,7 @@
 
 #include <glib-object.h>
 #include <gio/gio.h>
+#include <gsf/gsf-input.h>
 
 G_BEGIN_DECLS
 
@@ -77,6 +78,10 @@ gssize          gsf_input_stream_read     (GInputStream   *base,
                                            gsize           buffer_len,
                                            GCancellable   *cancellable,
                                            GError        **error);
+gssize          gsf_input_stream_skip     (GInputStream   *base,
+                                           gsize           count,
+                                           GCancellable   *cancellable,
+                                           GError        **error);
 gboolean        gsf_input_stream_close    (GInputStream   *base,
                                            GCancellable   *cancellable,
                                            GError        **error);
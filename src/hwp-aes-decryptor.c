@@ -0,0 +1,169 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/*
+ * hwp-aes-decryptor.c
+ * This file is part of the libhwp project.
+ *
+ * Copyright (C) 2016 Hodong Kim <cogniti@gmail.com>
+ *
+ * The libhwp is dual licensed under the LGPL v3+ or Apache License 2.0
+ *
+ * The libhwp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The libhwp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program;  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Or,
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * AES-128-ECB decryption without padding as a GConverter, so that the
+ * sections of distribution documents can be decrypted block by block as
+ * the parser reads them, instead of all at once into memory.
+ */
+
+#include <string.h>
+#include <openssl/evp.h>
+
+#include "hwp-aes-decryptor.h"
+
+#define AES_BLOCK 16
+
+struct _HwpAesDecryptor
+{
+  GObject         parent_instance;
+
+  guint8          key[16];
+  EVP_CIPHER_CTX *ctx;
+};
+
+struct _HwpAesDecryptorClass
+{
+  GObjectClass parent_class;
+};
+
+static void hwp_aes_decryptor_iface_init (GConverterIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (HwpAesDecryptor, _hwp_aes_decryptor, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (G_TYPE_CONVERTER,
+                                                hwp_aes_decryptor_iface_init));
+
+static void hwp_aes_decryptor_start (HwpAesDecryptor *decryptor)
+{
+  EVP_DecryptInit_ex (decryptor->ctx, EVP_aes_128_ecb (), NULL,
+                      decryptor->key, NULL);
+  EVP_CIPHER_CTX_set_padding (decryptor->ctx, 0); /* no padding */
+}
+
+GConverter *_hwp_aes_decryptor_new (const guint8 key[16])
+{
+  HwpAesDecryptor *decryptor = g_object_new (HWP_TYPE_AES_DECRYPTOR, NULL);
+  memcpy (decryptor->key, key, 16);
+  hwp_aes_decryptor_start (decryptor);
+
+  return G_CONVERTER (decryptor);
+}
+
+static GConverterResult
+hwp_aes_decryptor_convert (GConverter      *converter,
+                           const void      *inbuf,
+                           gsize            inbuf_size,
+                           void            *outbuf,
+                           gsize            outbuf_size,
+                           GConverterFlags  flags,
+                           gsize           *bytes_read,
+                           gsize           *bytes_written,
+                           GError         **error)
+{
+  HwpAesDecryptor *decryptor = HWP_AES_DECRYPTOR (converter);
+  gsize            n_blocks  = MIN (MIN (inbuf_size, outbuf_size),
+                                      G_MAXINT) / AES_BLOCK;
+  int              len       = 0;
+
+  if (n_blocks == 0)
+  {
+    /* like EVP_DecryptFinal_ex without padding, a trailing partial block
+     * is dropped */
+    if (inbuf_size < AES_BLOCK && (flags & G_CONVERTER_INPUT_AT_END))
+    {
+      *bytes_read    = inbuf_size;
+      *bytes_written = 0;
+      return G_CONVERTER_FINISHED;
+    }
+
+    if (inbuf_size < AES_BLOCK)
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_PARTIAL_INPUT,
+                           "Need more input");
+    else
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NO_SPACE,
+                           "Need more output space");
+    return G_CONVERTER_ERROR;
+  }
+
+  if (!EVP_DecryptUpdate (decryptor->ctx, outbuf, &len,
+                          inbuf, (int) (n_blocks * AES_BLOCK)))
+  {
+    g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                         "Decryption failed");
+    return G_CONVERTER_ERROR;
+  }
+
+  *bytes_read    = len;
+  *bytes_written = len;
+
+  if ((flags & G_CONVERTER_INPUT_AT_END) && *bytes_read == inbuf_size)
+    return G_CONVERTER_FINISHED;
+
+  return G_CONVERTER_CONVERTED;
+}
+
+static void hwp_aes_decryptor_reset (GConverter *converter)
+{
+  hwp_aes_decryptor_start (HWP_AES_DECRYPTOR (converter));
+}
+
+static void hwp_aes_decryptor_iface_init (GConverterIface *iface)
+{
+  iface->convert = hwp_aes_decryptor_convert;
+  iface->reset   = hwp_aes_decryptor_reset;
+}
+
+static void _hwp_aes_decryptor_finalize (GObject *object)
+{
+  HwpAesDecryptor *decryptor = HWP_AES_DECRYPTOR (object);
+
+  EVP_CIPHER_CTX_free (decryptor->ctx);
+  memset (decryptor->key, 0, sizeof decryptor->key);
+
+  G_OBJECT_CLASS (_hwp_aes_decryptor_parent_class)->finalize (object);
+}
+
+static void _hwp_aes_decryptor_class_init (HwpAesDecryptorClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  object_class->finalize = _hwp_aes_decryptor_finalize;
+}
+
+static void _hwp_aes_decryptor_init (HwpAesDecryptor *decryptor)
+{
+  decryptor->ctx = EVP_CIPHER_CTX_new ();
+}
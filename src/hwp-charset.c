@@ -37,8 +37,73 @@
 
 #include <glib.h>
 #include "hwp-charset.h"
+#include "hwp-charset-pages.h"
 #include <stdio.h>
 
+/* two-level lookup in the tables of hwp-charset-pages.h: returns the
+ * UTF-16 code units, at most 3, that character @index of @page maps to */
+static inline const guint16 *page_lookup (guint16 page, guint index, guint *n)
+{
+  const guint8 *offsets = charset_page_offsets[page];
+
+  *n = offsets[index + 1] - offsets[index];
+  return charset_units + charset_page_base[page] + offsets[index];
+}
+
+/* writes the UTF-8 of @n code units to @out, at most HWP_CHAR_UTF8_MAX
+ * bytes; surrogate pairs come from the supplementary planes */
+static inline gsize units_to_utf8 (const guint16 *units, guint n, gchar *out)
+{
+  guint8 *p = (guint8 *) out;
+
+  for (guint i = 0; i < n; i++)
+  {
+    gunichar c = units[i];
+
+    if (c < 0x80) {
+      *p++ = c;
+    } else if (c < 0x800) {
+      *p++ = 0xc0 | (c >> 6);
+      *p++ = 0x80 | (c & 0x3f);
+    } else if (c >= 0xd800 && c <= 0xdbff && i + 1 < n) {
+      c = 0x10000 + ((c - 0xd800) << 10) + (units[++i] - 0xdc00);
+      *p++ = 0xf0 | (c >> 18);
+      *p++ = 0x80 | ((c >> 12) & 0x3f);
+      *p++ = 0x80 | ((c >> 6) & 0x3f);
+      *p++ = 0x80 | (c & 0x3f);
+    } else {
+      *p++ = 0xe0 | (c >> 12);
+      *p++ = 0x80 | ((c >> 6) & 0x3f);
+      *p++ = 0x80 | (c & 0x3f);
+    }
+  }
+
+  return p - (guint8 *) out;
+}
+
+static inline gsize hnchar_utf8 (guint16 c, gchar *buf)
+{
+  const guint16 *units;
+  guint          n;
+
+  units = page_lookup (hnc_page[c >> CHARSET_PAGE_BITS],
+                       c & ((1 << CHARSET_PAGE_BITS) - 1), &n);
+  return units_to_utf8 (units, n, buf);
+}
+
+static inline gsize hychar_utf8 (guint16 c, gchar *buf)
+{
+  const guint16 *units;
+  guint          n;
+
+  if (c < 0xe0bc || c > 0xf8f7)
+    return 0;
+
+  units = page_lookup (hyc_page[(c >> CHARSET_PAGE_BITS) - HYC_FIRST_PAGE],
+                       c & ((1 << CHARSET_PAGE_BITS) - 1), &n);
+  return units_to_utf8 (units, n, buf);
+}
+
 /**
  * hwp_hnchar_to_utf8:
  * @c: a hnc character code
@@ -53,32 +118,12 @@
  */
 gchar *hwp_hnchar_to_utf8 (guint16 c)
 {
-  GString *string = g_string_new (NULL);
-   /* ASCII printable characters */
-  if (c >= 0x0020 && c <= 0x007e) {
-      g_string_append_unichar (string, c);
-  } else if (c >= 0x007f && c <= 0x3fff) {
-      g_string_append_unichar (string, hnc2uni_page0[c]);
-  /* 1수준 한자 4888자 */
-  } else if (c >= 0x4000 && c <= 0x5317) {
-      g_string_append_unichar (string, hnc2uni_page4[c-0x4000]);
-  /* 2수준 한자 */
-  } else if (c >= 0x5318 && c <= 0x7fff) {
-      g_string_append_unichar (string, hnc2uni_page5[c-0x5318]);
-  /* 한글 영역 */
-  } else if (c >= 0x8000 && c <= 0xffff) {
-    const gunichar2 *unichar2;
-    unichar2 = hnc2uni_page8[c-0x8000];
-    for (guint8 i = 0; i < 3; i++)
-    {
-      if (unichar2[i] == 0)
-        break;
-      g_string_append_unichar (string, unichar2[i]);
-    }
-  } else {
+  gchar buf[HWP_CHAR_UTF8_MAX];
+
+  if (c < 0x0020)
     g_warning ("%04x: out of hnc code range", c);
-  }
-  return g_string_free (string, FALSE);
+
+  return g_strndup (buf, hnchar_utf8 (c, buf));
 }
 
 /**
@@ -95,20 +140,84 @@ gchar *hwp_hnchar_to_utf8 (guint16 c)
  */
 gchar *hwp_hychar_to_utf8 (guint16 c)
 {
-  GString *string = g_string_new (NULL);
-  /* 한양PUA 코드 */
-  if (c >= 0xe0bc && c <= 0xf8f7)
-  {
-    const gunichar2 *unichar2;
-    unichar2 = hyc2uni_page14[c-0xe0bc];
-    for (guint8 i = 0; i < 3; i++)
-    {
-      if (unichar2[i] == 0)
-        break;
-      g_string_append_unichar (string, unichar2[i]);
-    }
-  } else {
+  gchar buf[HWP_CHAR_UTF8_MAX];
+
+  if (c < 0xe0bc || c > 0xf8f7)
     g_warning ("%04x: out of hypua code range", c);
-  }
-  return g_string_free (string, FALSE);
+
+  return g_strndup (buf, hychar_utf8 (c, buf));
+}
+
+/**
+ * hwp_hnchar_to_utf8_buf:
+ * @c: a hnc character code
+ * @buf: (out caller-allocates): output buffer, at least
+ *   %HWP_CHAR_UTF8_MAX bytes long
+ *
+ * Converts a single character to UTF-8 into @buf, without allocating.
+ * The result is not nul-terminated.  Characters without a mapping, such
+ * as control codes, produce no output.
+ *
+ * Return value: the number of bytes written to @buf
+ *
+ * Since: 2016.06.01
+ */
+gsize hwp_hnchar_to_utf8_buf (guint16 c, gchar *buf)
+{
+  return hnchar_utf8 (c, buf);
+}
+
+/**
+ * hwp_hychar_to_utf8_buf:
+ * @c: a hypua character code
+ * @buf: (out caller-allocates): output buffer, at least
+ *   %HWP_CHAR_UTF8_MAX bytes long
+ *
+ * Converts a single character to UTF-8 into @buf, without allocating.
+ * The result is not nul-terminated.  Codes outside the hypua range
+ * produce no output.
+ *
+ * Return value: the number of bytes written to @buf
+ *
+ * Since: 2016.06.01
+ */
+gsize hwp_hychar_to_utf8_buf (guint16 c, gchar *buf)
+{
+  return hychar_utf8 (c, buf);
+}
+
+/**
+ * hwp_hnchar_append_utf8:
+ * @c: a hnc character code
+ * @string: a #GString
+ *
+ * Appends the UTF-8 of a single character to @string.  Characters without
+ * a mapping, such as control codes, append nothing.
+ *
+ * Since: 2016.06.01
+ */
+void hwp_hnchar_append_utf8 (guint16 c, GString *string)
+{
+  gchar buf[HWP_CHAR_UTF8_MAX];
+
+  g_string_append_len (string, buf, hnchar_utf8 (c, buf));
+}
+
+/**
+ * hwp_hychar_append_utf8:
+ * @c: a hypua character code
+ * @string: a #GString
+ *
+ * Appends the UTF-8 of a single character to @string.  Codes outside the
+ * hypua range append nothing.
+ *
+ * Since: 2016.06.01
+ */
+void hwp_hychar_append_utf8 (guint16 c, GString *string)
+{
+  gchar buf[HWP_CHAR_UTF8_MAX];
+  gsize len = hychar_utf8 (c, buf);
+
+  if (len)
+    g_string_append_len (string, buf, len);
 }
@@ -77,6 +77,50 @@ typedef enum
     HWP_ERROR_DAMAGED
 } HwpError;
 
+/**
+ * HwpParseFlags:
+ * @HWP_PARSE_FLAGS_NONE: parse the whole document
+ * @HWP_PARSE_FLAGS_METADATA_ONLY: report only the document version, the
+ *   summary information and the preview text; the document body is never
+ *   read, so the cost does not depend on its size
+ * @HWP_PARSE_FLAGS_PARALLEL_SECTIONS: inflate and parse the sections of a
+ *   HWP5 or HWPX document on a thread pool.  Listener callbacks are still
+ *   invoked from the thread that called the parser, never concurrently,
+ *   and by default in document order
+ * @HWP_PARSE_FLAGS_UNORDERED: with %HWP_PARSE_FLAGS_PARALLEL_SECTIONS,
+ *   deliver the paragraphs of each section as soon as it is parsed instead
+ *   of in document order; use #HwpParagraph.section_index to tell sections
+ *   apart
+ * @HWP_PARSE_FLAGS_PIPELINE: parse a HWP5 document with three overlapping
+ *   stages: one thread inflates the sections ahead, one decodes records
+ *   into paragraphs, and the calling thread invokes the listener.  The
+ *   stages are connected by bounded queues and paragraphs keep document
+ *   order.  Ignored with %HWP_PARSE_FLAGS_PARALLEL_SECTIONS
+ * @HWP_PARSE_FLAGS_PARALLEL_PARAGRAPHS: inflate each HWP5 section into
+ *   memory, find its top level paragraphs from the record headers alone
+ *   and decode runs of them on a thread pool; paragraphs are delivered in
+ *   document order from the calling thread.  Helps documents with one
+ *   huge section.  Ignored with %HWP_PARSE_FLAGS_PARALLEL_SECTIONS
+ * @HWP_PARSE_FLAGS_TEXT_ONLY: decode only the paragraph text of a HWP5
+ *   document.  Character shape runs, #HwpParagraph.m_pos, m_id, m_offset
+ *   and the text attributes are not produced, and DocInfo (fonts,
+ *   character and paragraph shapes, BinData) is not reported
+ *
+ * Flags controlling how much of a document a parser reads.
+ *
+ * Since: 2016.06.01
+ */
+typedef enum /*< flags >*/
+{
+  HWP_PARSE_FLAGS_NONE                = 0,
+  HWP_PARSE_FLAGS_METADATA_ONLY       = 1 << 0,
+  HWP_PARSE_FLAGS_PARALLEL_SECTIONS   = 1 << 1,
+  HWP_PARSE_FLAGS_UNORDERED           = 1 << 2,
+  HWP_PARSE_FLAGS_PIPELINE            = 1 << 3,
+  HWP_PARSE_FLAGS_PARALLEL_PARAGRAPHS = 1 << 4,
+  HWP_PARSE_FLAGS_TEXT_ONLY           = 1 << 5
+} HwpParseFlags;
+
 #ifndef __GTK_DOC_IGNORE__
 typedef enum {
   HWP_PARSE_STATE_NORMAL,
@@ -0,0 +1,93 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/*
+ * hwp-file-private.h
+ * This file is part of the libhwp project.
+ *
+ * Copyright (C) 2016 Hodong Kim <cogniti@gmail.com>
+ *
+ * The libhwp is dual licensed under the LGPL v3+ or Apache License 2.0
+ *
+ * The libhwp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The libhwp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program;  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Or,
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HWP_FILE_PRIVATE_H__
+#define __HWP_FILE_PRIVATE_H__
+
+#include <gsf/gsf-input.h>
+
+#include "hwp-hwp3-file.h"
+#include "hwp-hwp5-file.h"
+#include "hwp-hwpml-file.h"
+#include "hwp-hwpx-file.h"
+
+G_BEGIN_DECLS
+
+/* HWPML (.hml) documents may come compressed as a gzip member */
+static inline gboolean _hwp_is_gzip (const guint8 *data, gsize len)
+{
+  return len >= 2 && data[0] == 0x1f && data[1] == 0x8b;
+}
+
+const guint8 *_hwp_input_stream_peek            (GBufferedInputStream *stream,
+                                                 gsize                 count,
+                                                 gsize                *len,
+                                                 GError              **error);
+
+/*
+ * Constructors taking the input hwp_file_new_for_{path,uri} already opened
+ * to sniff the format.  The input must be rewound to offset 0; each
+ * constructor takes the references it needs.
+ */
+HwpHWP5File  *_hwp_hwp5_file_new_for_gsf_input  (GsfInput *input,
+                                                 GError  **error);
+HwpHWP3File  *_hwp_hwp3_file_new_for_gsf_input  (GsfInput *input,
+                                                 GError  **error);
+HwpHWPMLFile *_hwp_hwpml_file_new_for_gsf_input (GsfInput *input,
+                                                 GError  **error);
+HwpHWPXFile  *_hwp_hwpx_file_new_for_gsf_input  (GsfInput *input,
+                                                 GError  **error);
+
+GInputStream *_hwp_hwp5_file_open_section       (HwpHWP5File *file,
+                                                 guint        index,
+                                                 gboolean     streaming,
+                                                 GError     **error);
+GBytes       *_hwp_hwp5_file_read_section       (HwpHWP5File *file,
+                                                 guint        index,
+                                                 GError     **error);
+GBytes       *_hwp_hwp5_file_read_doc_info      (HwpHWP5File *file,
+                                                 GError     **error);
+GBytes       *_hwp_hwp3_file_get_bytes          (HwpHWP3File *file,
+                                                 gsize        max_len,
+                                                 GError     **error);
+GBytes       *_hwp_hwpx_file_get_entry_bytes    (HwpHWPXFile *file,
+                                                 const gchar *name,
+                                                 GError     **error);
+
+G_END_DECLS
+
+#endif /* __HWP_FILE_PRIVATE_H__ */
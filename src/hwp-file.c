@@ -44,10 +44,14 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <gsf/gsf-input-gio.h>
+#include <gsf/gsf-input-stdio.h>
 #include "hwp-file.h"
+#include "hwp-file-private.h"
 #include "hwp-hwp3-file.h"
 #include "hwp-hwp5-file.h"
 #include "hwp-hwpml-file.h"
+#include "hwp-hwpx-file.h"
 
 #include "config.h"
 #include <glib/gi18n-lib.h>
@@ -106,25 +110,35 @@ gchar *hwp_file_get_hwp_version_string (HwpFile *file)
   return HWP_FILE_GET_CLASS (file)->get_hwp_version_string (file);
 }
 
-static gboolean is_hwpml (gchar *haystack, gsize haystack_len)
+/* ASCII-only, case-insensitive search; allocation-free */
+static const gchar *find_ascii_nocase (const gchar *haystack,
+                                       gsize        haystack_len,
+                                       const gchar *needle)
 {
-  gchar *ptr1;
-  gchar *ptr2;
-  gchar *lowercase       = g_utf8_strdown (haystack, haystack_len);
-  gchar *signature_xml   = g_utf8_strdown ("<?xml version=\"", 15);
-  gchar *signature_hwpml = g_utf8_strdown ("<HWPML Version=\"", 16);
+  gsize needle_len = strlen (needle);
+  gsize i;
 
-  ptr1 = g_strstr_len (lowercase, haystack_len, signature_xml);
-  ptr2 = g_strstr_len (lowercase, haystack_len, signature_hwpml);
+  for (i = 0; i + needle_len <= haystack_len; i++)
+    if (g_ascii_strncasecmp (haystack + i, needle, needle_len) == 0)
+      return haystack + i;
 
-  g_free (lowercase);
-  g_free (signature_xml);
-  g_free (signature_hwpml);
+  return NULL;
+}
 
-  if (ptr1 && ptr2 && (ptr1 < ptr2))
-    return TRUE;
-  else
+static gboolean is_hwpml (const guint8 *haystack, gsize haystack_len)
+{
+  const gchar *ptr1;
+  const gchar *ptr2;
+  const gchar *end = (const gchar *) haystack + haystack_len;
+
+  ptr1 = find_ascii_nocase ((const gchar *) haystack, haystack_len,
+                            "<?xml version=\"");
+  if (!ptr1)
     return FALSE;
+
+  ptr2 = find_ascii_nocase (ptr1, end - ptr1, "<hwpml version=\"");
+
+  return ptr2 != NULL;
 }
 
 static const guint8 signature_ole[] =
@@ -141,6 +155,120 @@ static const guint8 signature_v3[] =
   0x1a, 0x01, 0x02, 0x03, 0x04, 0x05
 };
 
+/*
+ * An HWPX package is a zip file whose first member, "mimetype", is stored
+ * uncompressed and holds "application/hwp+zip".
+ */
+static gboolean is_hwpx (const guint8 *data, gsize len)
+{
+  if (len < 30 || memcmp (data, "PK\3\4", 4) != 0)
+    return FALSE;
+
+  return find_ascii_nocase ((const gchar *) data + 30, len - 30,
+                            "application/hwp+zip") != NULL;
+}
+
+/* inflates the start of a gzip member into @out, only to sniff it */
+static gsize gunzip_prefix (const guint8 *data,
+                            gsize         len,
+                            guint8       *out,
+                            gsize         out_len)
+{
+  GZlibDecompressor *zd;
+  GConverterResult   result;
+  gsize              bytes_read;
+  gsize              bytes_written;
+  gsize              total = 0;
+
+  zd = g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP);
+
+  do {
+    result = g_converter_convert (G_CONVERTER (zd), data, len,
+                                  out + total, out_len - total,
+                                  G_CONVERTER_NO_FLAGS,
+                                  &bytes_read, &bytes_written, NULL);
+    data  += bytes_read;
+    len   -= bytes_read;
+    total += bytes_written;
+  } while (result == G_CONVERTER_CONVERTED && len > 0 && total < out_len);
+
+  g_object_unref (zd);
+
+  return total;
+}
+
+static gboolean is_hwpml_gzip (const guint8 *data, gsize len)
+{
+  guint8 buffer[4096];
+
+  return _hwp_is_gzip (data, len) &&
+         is_hwpml (buffer, gunzip_prefix (data, len, buffer, sizeof buffer));
+}
+
+/*
+ * Makes sure the first @count bytes (fewer at the end of the stream) are
+ * in the buffer of @stream and returns them without consuming them, so
+ * the format can be sniffed and the same bytes parsed afterwards.
+ */
+const guint8 *_hwp_input_stream_peek (GBufferedInputStream *stream,
+                                      gsize                 count,
+                                      gsize                *len,
+                                      GError              **error)
+{
+  gsize  available;
+  gssize n;
+
+  if (g_buffered_input_stream_get_buffer_size (stream) < count)
+    g_buffered_input_stream_set_buffer_size (stream, count);
+
+  while ((available = g_buffered_input_stream_get_available (stream)) < count)
+  {
+    n = g_buffered_input_stream_fill (stream, count - available, NULL, error);
+
+    if (n < 0)
+      return NULL;
+
+    if (n == 0)
+      break;
+  }
+
+  return g_buffered_input_stream_peek_buffer (stream, len);
+}
+
+/* consumes the reference to @input */
+static HwpFile *hwp_file_new_for_gsf_input (GsfInput *input, GError **error)
+{
+  guint8    buffer[4096];
+  gsf_off_t len    = MIN (gsf_input_size (input), (gsf_off_t) sizeof buffer);
+  HwpFile  *retval = NULL;
+
+  if ((len > 0 && !gsf_input_read (input, len, buffer)) ||
+      gsf_input_seek (input, 0, G_SEEK_SET)) {
+    g_set_error (error, HWP_FILE_ERROR, HWP_FILE_ERROR_FAILED,
+                        "failed to read %s", gsf_input_name (input));
+    g_object_unref (input);
+    return NULL;
+  }
+
+  if (len >= sizeof(signature_ole) &&
+      memcmp(buffer, signature_ole, sizeof(signature_ole)) == 0)
+    retval = HWP_FILE (_hwp_hwp5_file_new_for_gsf_input (input, error));
+  else if (len >= sizeof(signature_v3) &&
+           memcmp(buffer, signature_v3, sizeof(signature_v3)) == 0)
+    retval = HWP_FILE (_hwp_hwp3_file_new_for_gsf_input (input, error));
+  else if (is_hwpml (buffer, len) || is_hwpml_gzip (buffer, len))
+    retval = HWP_FILE (_hwp_hwpml_file_new_for_gsf_input (input, error));
+  else if (is_hwpx (buffer, len))
+    retval = HWP_FILE (_hwp_hwpx_file_new_for_gsf_input (input, error));
+  else
+    g_set_error (error, HWP_FILE_ERROR, HWP_FILE_ERROR_INVALID,
+                        "invalid hwp file");
+
+  g_object_unref (input);
+
+  return retval;
+}
+
 /**
  * hwp_file_new_for_path:
  * @path: path of the file to load
@@ -158,38 +286,79 @@ HwpFile *hwp_file_new_for_path (const gchar *path, GError **error)
 {
   g_return_val_if_fail (path != NULL, NULL);
 
-  GFile            *file   = g_file_new_for_path (path);
-  GFileInputStream *stream = g_file_read (file, NULL, error);
-  g_object_unref (file);
+  GsfInput *input = gsf_input_stdio_new (path, error);
 
-  if (*error)
+  if (!input)
     return NULL;
 
-  gsize bytes_read = 0;
-  guint8 *buffer = g_malloc0 (4096);
-  g_input_stream_read_all (G_INPUT_STREAM(stream), buffer, 4096,
-                           &bytes_read, NULL, error);
-  g_object_unref (stream);
-
-  HwpFile *retval = NULL;
-
-  if (memcmp(buffer, signature_ole, sizeof(signature_ole)) == 0) {
-    /* hwp v5 */
-    retval = HWP_FILE (hwp_hwp5_file_new_for_path (path, error));
-  } else if (memcmp(buffer, signature_v3, sizeof(signature_v3)) == 0) {
-    /* hwp v3 */
-    retval = HWP_FILE (hwp_hwp3_file_new_for_path (path, error));
-  } else if (is_hwpml((gchar *) buffer, bytes_read)) {
-    /* hwp ml */
-    retval = HWP_FILE (hwp_hwpml_file_new_for_path (path, error));
-  } else {
-    /* invalid hwp file */
-    g_set_error (error, HWP_FILE_ERROR, HWP_FILE_ERROR_INVALID,
-                        "invalid hwp file");
-  }
+  return hwp_file_new_for_gsf_input (input, error);
+}
 
-  g_free(buffer);
-  return retval;
+static void new_for_path_thread (GTask        *task,
+                                 gpointer      source_object,
+                                 gpointer      task_data,
+                                 GCancellable *cancellable)
+{
+  HwpFile *file;
+  GError  *error = NULL;
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  file = hwp_file_new_for_path (task_data, &error);
+
+  if (file)
+    g_task_return_pointer (task, file, g_object_unref);
+  else
+    g_task_return_error (task, error);
+}
+
+/**
+ * hwp_file_new_for_path_async:
+ * @path: path of the file to load
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore
+ * @callback: (scope async): a #GAsyncReadyCallback to call when done
+ * @user_data: (closure): the data to pass to @callback
+ *
+ * Opens @path on a worker thread, as hwp_file_new_for_path() does, and
+ * calls @callback in the thread-default main context of the caller;
+ * call hwp_file_new_for_path_finish() from it to get the #HwpFile.
+ *
+ * Since: 2016.06.01
+ */
+void hwp_file_new_for_path_async (const gchar         *path,
+                                  GCancellable        *cancellable,
+                                  GAsyncReadyCallback  callback,
+                                  gpointer             user_data)
+{
+  GTask *task;
+
+  g_return_if_fail (path != NULL);
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  task = g_task_new (NULL, cancellable, callback, user_data);
+  g_task_set_source_tag (task, hwp_file_new_for_path_async);
+  g_task_set_task_data (task, g_strdup (path), g_free);
+  g_task_run_in_thread (task, new_for_path_thread);
+  g_object_unref (task);
+}
+
+/**
+ * hwp_file_new_for_path_finish:
+ * @result: a #GAsyncResult
+ * @error: location to store the error occurring, or %NULL to ignore
+ *
+ * Finishes an operation started with hwp_file_new_for_path_async().
+ *
+ * Return value: (transfer full): A newly created #HwpFile, or %NULL
+ *
+ * Since: 2016.06.01
+ */
+HwpFile *hwp_file_new_for_path_finish (GAsyncResult *result, GError **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, NULL), NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
 }
 
 /**
@@ -209,32 +378,148 @@ HwpFile *hwp_file_new_for_uri (const gchar *uri, GError **error)
 {
   g_return_val_if_fail (uri != NULL, NULL);
 
-  GFile            *file   = g_file_new_for_uri (uri);
-  GFileInputStream *stream = g_file_read (file, NULL, error);
-  g_object_unref (file);
+  GsfInput *input = gsf_input_gio_new_for_uri (uri, error);
 
-  if (*error)
+  if (!input)
     return NULL;
 
-  gsize bytes_read = 0;
-  guint8 *buffer = g_malloc0 (4096);
-  g_input_stream_read_all (G_INPUT_STREAM(stream), buffer, 4096,
-                           &bytes_read, NULL, error);
-  g_object_unref (stream);
-
-  HwpFile *retval = NULL;
+  return hwp_file_new_for_gsf_input (input, error);
+}
 
-  if (memcmp(buffer, signature_ole, sizeof(signature_ole)) == 0)
-    retval = HWP_FILE (hwp_hwp5_file_new_for_uri (uri, error));
-  else if (memcmp(buffer, signature_v3, sizeof(signature_v3)) == 0)
-    retval = HWP_FILE (hwp_hwp3_file_new_for_uri (uri, error));
-  else if (is_hwpml((gchar *) buffer, bytes_read))
-    retval = HWP_FILE (hwp_hwpml_file_new_for_uri (uri, error));
+/**
+ * hwp_file_new_for_bytes:
+ * @bytes: a #GBytes containing the whole document
+ * @error: location to store the error occurring, or %NULL to ignore
+ *
+ * Creates a new #HwpFile which reads the document directly from @bytes.
+ * The format is detected from the contents of @bytes and no temporary file
+ * is written. If %NULL is returned, then @error will be set. Possible errors
+ * include those in the #HWP_ERROR and #HWP_FILE_ERROR domains.
+ *
+ * Return value: A newly created #HwpFile, or %NULL
+ *
+ * Since: 2016.06.01
+ */
+HwpFile *hwp_file_new_for_bytes (GBytes *bytes, GError **error)
+{
+  g_return_val_if_fail (bytes != NULL, NULL);
+
+  gsize         size;
+  const guint8 *data   = g_bytes_get_data (bytes, &size);
+  HwpFile      *retval = NULL;
+
+  if (size >= sizeof(signature_ole) &&
+      memcmp(data, signature_ole, sizeof(signature_ole)) == 0)
+    retval = HWP_FILE (hwp_hwp5_file_new_for_bytes (bytes, error));
+  else if (size >= sizeof(signature_v3) &&
+           memcmp(data, signature_v3, sizeof(signature_v3)) == 0)
+    retval = HWP_FILE (hwp_hwp3_file_new_for_bytes (bytes, error));
+  else if (is_hwpml (data, MIN (size, 4096)) ||
+           is_hwpml_gzip (data, MIN (size, 4096)))
+    retval = HWP_FILE (hwp_hwpml_file_new_for_bytes (bytes, error));
+  else if (is_hwpx (data, MIN (size, 4096)))
+    retval = HWP_FILE (hwp_hwpx_file_new_for_bytes (bytes, error));
   else
     g_set_error (error, HWP_FILE_ERROR, HWP_FILE_ERROR_INVALID,
                         "invalid hwp file");
 
-  g_free(buffer);
+  return retval;
+}
+
+/**
+ * hwp_file_new_for_mapped_path:
+ * @path: path of the file to load
+ * @error: location to store the error occurring, or %NULL to ignore
+ *
+ * Creates a new #HwpFile backed by a read-only memory mapping of @path.
+ * The mapping stays alive as long as the returned file does, so the
+ * document is never copied into the heap. If %NULL is returned, then
+ * @error will be set. Possible errors include those in the #G_FILE_ERROR,
+ * #HWP_ERROR and #HWP_FILE_ERROR domains.
+ *
+ * Return value: A newly created #HwpFile, or %NULL
+ *
+ * Since: 2016.06.01
+ */
+HwpFile *hwp_file_new_for_mapped_path (const gchar *path, GError **error)
+{
+  g_return_val_if_fail (path != NULL, NULL);
+
+  GMappedFile *mapped = g_mapped_file_new (path, FALSE, error);
+
+  if (!mapped)
+    return NULL;
+
+  /* GBytes 가 mapping 에 대한 참조를 유지한다 */
+  GBytes  *bytes  = g_mapped_file_get_bytes (mapped);
+  HwpFile *retval = hwp_file_new_for_bytes (bytes, error);
+  g_bytes_unref (bytes);
+  g_mapped_file_unref (mapped);
+
+  return retval;
+}
+
+/**
+ * hwp_file_new_for_stream:
+ * @stream: a #GInputStream positioned at the start of the document
+ * @error: location to store the error occurring, or %NULL to ignore
+ *
+ * Creates a new #HwpFile which reads the document from @stream, which may
+ * be a pipe or a socket. The format is sniffed from a buffered prefix that
+ * is then parsed, so nothing is read twice. HWPML documents, also gzip
+ * compressed ones, are parsed straight from @stream and can be parsed
+ * once; HWP 3.0, HWP 5.0 and HWPX documents are read into memory first. If %NULL
+ * is returned, then @error will be set. Possible errors include those in
+ * the #G_IO_ERROR, #HWP_ERROR and #HWP_FILE_ERROR domains.
+ *
+ * Return value: A newly created #HwpFile, or %NULL
+ *
+ * Since: 2016.06.01
+ */
+HwpFile *hwp_file_new_for_stream (GInputStream *stream, GError **error)
+{
+  g_return_val_if_fail (G_IS_INPUT_STREAM (stream), NULL);
+
+  GInputStream  *buffered;
+  GOutputStream *output;
+  GBytes        *bytes;
+  const guint8  *data;
+  gsize          len;
+  HwpFile       *retval = NULL;
+
+  if (G_IS_BUFFERED_INPUT_STREAM (stream))
+    buffered = g_object_ref (stream);
+  else
+    buffered = g_buffered_input_stream_new (stream);
+
+  data = _hwp_input_stream_peek (G_BUFFERED_INPUT_STREAM (buffered), 4096,
+                                 &len, error);
+  if (!data)
+    goto FINALLY;
+
+  if (is_hwpml (data, len) || is_hwpml_gzip (data, len))
+  {
+    retval = HWP_FILE (hwp_hwpml_file_new_for_stream (buffered, error));
+    goto FINALLY;
+  }
+
+  /* OLE 와 zip 은 임의 접근이 필요하므로 메모리로 읽는다 */
+  output = g_memory_output_stream_new_resizable ();
+
+  if (g_output_stream_splice (output, buffered,
+                              G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET,
+                              NULL, error) >= 0)
+  {
+    bytes  = g_memory_output_stream_steal_as_bytes (G_MEMORY_OUTPUT_STREAM (output));
+    retval = hwp_file_new_for_bytes (bytes, error);
+    g_bytes_unref (bytes);
+  }
+
+  g_object_unref (output);
+
+  FINALLY:
+
+  g_object_unref (buffered);
 
   return retval;
 }
@@ -111,8 +111,20 @@ GType        hwp_file_get_type               (void) G_GNUC_CONST;
 GQuark       hwp_file_error_quark            (void) G_GNUC_CONST;
 HwpFile     *hwp_file_new_for_path           (const gchar *path,
                                               GError     **error);
+void         hwp_file_new_for_path_async     (const gchar         *path,
+                                              GCancellable        *cancellable,
+                                              GAsyncReadyCallback  callback,
+                                              gpointer             user_data);
+HwpFile     *hwp_file_new_for_path_finish    (GAsyncResult *result,
+                                              GError      **error);
 HwpFile     *hwp_file_new_for_uri            (const gchar *uri,
                                               GError     **error);
+HwpFile     *hwp_file_new_for_bytes          (GBytes      *bytes,
+                                              GError     **error);
+HwpFile     *hwp_file_new_for_mapped_path    (const gchar *path,
+                                              GError     **error);
+HwpFile     *hwp_file_new_for_stream         (GInputStream *stream,
+                                              GError      **error);
 gchar       *hwp_file_get_hwp_version_string (HwpFile     *file);
 void         hwp_file_get_hwp_version        (HwpFile     *file,
                                               guint8      *major_version,
@@ -42,6 +42,13 @@
  * 한글과컴퓨터의 한/글 문서 파일(.hwp) 공개 문서를 참고하여 개발하였습니다.
  */
 
+#include "config.h"
+
+#include <glib/gi18n-lib.h>
+
+#include "gsf-input-stream.h"
+#include "hwp-enums.h"
+#include "hwp-file-private.h"
 #include "hwp-hwp3-file.h"
 #include "hwp-hwp3-parser.h"
 
@@ -57,6 +64,15 @@ static HwpHWP3File *hwp_hwp3_file_new_for_gfile (GFile   *gfile,
   return file;
 }
 
+HwpHWP3File *_hwp_hwp3_file_new_for_gsf_input (GsfInput *input,
+                                              GError  **error)
+{
+  HwpHWP3File *file = g_object_new (HWP_TYPE_HWP3_FILE, NULL);
+  file->priv->stream = G_INPUT_STREAM (gsf_input_stream_new (input));
+
+  return file;
+}
+
 /**
  * hwp_hwp3_file_new_for_path:
  * @path: path of the file to load
@@ -105,6 +121,93 @@ HwpHWP3File *hwp_hwp3_file_new_for_uri (const gchar  *uri,
   return file;
 }
 
+/**
+ * hwp_hwp3_file_new_for_bytes:
+ * @bytes: a #GBytes containing the whole document
+ * @error: location to store the error occurring, or %NULL to ignore
+ *
+ * Creates a new #HwpHWP3File which reads the document directly from
+ * @bytes, without copying it. If %NULL is returned, then @error will be
+ * set. Possible errors include those in the #HWP_ERROR and #HWP_FILE_ERROR
+ * domains.
+ *
+ * Return value: A newly created #HwpHWP3File, or %NULL
+ *
+ * Since: 2016.06.01
+ */
+HwpHWP3File *hwp_hwp3_file_new_for_bytes (GBytes  *bytes,
+                                          GError **error)
+{
+  g_return_val_if_fail (bytes != NULL, NULL);
+
+  HwpHWP3File *file = g_object_new (HWP_TYPE_HWP3_FILE, NULL);
+  file->priv->stream = g_memory_input_stream_new_from_bytes (bytes);
+  file->priv->bytes  = g_bytes_ref (bytes);
+
+  return file;
+}
+
+/*
+ * Returns the first @max_len bytes of the document (all of it when
+ * @max_len is G_MAXSIZE) as one contiguous block for the parser.
+ * The stream is read in large chunks and never rewound: what has been
+ * read is kept, and a later call with a larger @max_len, e.g. a full
+ * parse after a metadata-only one, goes on from where the stream was
+ * left.  Once the whole document has been read, later parses and
+ * hwp_hwp3_file_new_for_bytes() do not touch the stream at all.
+ */
+GBytes *_hwp_hwp3_file_get_bytes (HwpHWP3File *file,
+                                  gsize        max_len,
+                                  GError     **error)
+{
+  g_return_val_if_fail (HWP_IS_HWP3_FILE (file), NULL);
+
+  GInputStream *stream = file->priv->stream;
+  GByteArray   *array;
+  gsize         bytes_read;
+
+  if (file->priv->bytes)
+    return g_bytes_ref (file->priv->bytes);
+
+  if (!stream)
+  {
+    g_set_error_literal (error, HWP_ERROR, HWP_ERROR_INVALID,
+                         _("File corrupted"));
+    return NULL;
+  }
+
+  if (!file->priv->prefix)
+    file->priv->prefix = g_byte_array_new ();
+
+  array = file->priv->prefix;
+
+  while (array->len < max_len)
+  {
+    guint    len  = array->len;
+    gsize    want = MIN (max_len - len, 64 * 1024);
+    gboolean ok;
+
+    g_byte_array_set_size (array, len + want);
+    ok = g_input_stream_read_all (stream, array->data + len, want,
+                                  &bytes_read, NULL, error);
+    /* 오류가 나도 읽은 만큼은 스트림 위치와 맞게 남겨 둔다 */
+    g_byte_array_set_size (array, len + bytes_read);
+
+    if (!ok)
+      return NULL;
+
+    if (bytes_read < want)
+    {
+      file->priv->bytes  = g_byte_array_free_to_bytes (array);
+      file->priv->prefix = NULL;
+      return g_bytes_ref (file->priv->bytes);
+    }
+  }
+
+  /* 앞부분만 필요하다; 작으므로 복사한다 */
+  return g_bytes_new (array->data, MIN (array->len, max_len));
+}
+
 /**
  * hwp_hwp3_file_get_hwp_version_string:
  * @file: a #HwpFile
@@ -153,7 +256,16 @@ static void hwp_hwp3_file_init (HwpHWP3File *file)
 static void hwp_hwp3_file_finalize (GObject *object)
 {
   HwpHWP3File *file = HWP_HWP3_FILE(object);
-  g_object_unref (file->priv->stream);
+
+  if (file->priv->stream)
+    g_object_unref (file->priv->stream);
+
+  if (file->priv->bytes)
+    g_bytes_unref (file->priv->bytes);
+
+  if (file->priv->prefix)
+    g_byte_array_unref (file->priv->prefix);
+
   G_OBJECT_CLASS (hwp_hwp3_file_parent_class)->finalize (object);
 }
 
@@ -97,6 +97,8 @@ struct _HwpHWP3FileClass
 struct _HwpHWP3FilePrivate
 {
   GInputStream *stream;
+  GBytes       *bytes;  /* the whole document, once read */
+  GByteArray   *prefix; /* what has been read of stream before that */
 };
 
 GType        hwp_hwp3_file_get_type               (void) G_GNUC_CONST;
@@ -105,6 +107,8 @@ HwpHWP3File *hwp_hwp3_file_new_for_path           (const gchar *path,
                                                    GError     **error);
 HwpHWP3File *hwp_hwp3_file_new_for_uri            (const gchar *uri,
                                                    GError     **error);
+HwpHWP3File *hwp_hwp3_file_new_for_bytes          (GBytes      *bytes,
+                                                   GError     **error);
 gchar       *hwp_hwp3_file_get_hwp_version_string (HwpFile     *file);
 void         hwp_hwp3_file_get_hwp_version        (HwpFile     *file,
                                                    guint8      *major_version,
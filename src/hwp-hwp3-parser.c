@@ -45,117 +45,100 @@
 #include "hwp-hwp3-parser.h"
 #include "hwp-hwp3-file.h"
 #include "hwp-charset.h"
+#include "hwp-file-private.h"
+#include "hwp-inflate.h"
 #include <math.h>
 #include <stdlib.h>
 
 G_DEFINE_TYPE (HwpHWP3Parser, hwp_hwp3_parser, G_TYPE_OBJECT);
 
-gboolean hwp_hwp3_parser_read (HwpHWP3Parser *parser, void *buffer, gsize count)
+/*
+ * The document is decoded from one contiguous buffer (the body inflated
+ * in a single call when compressed), so the readers below are plain
+ * pointer reads.  Past the end of the buffer they fail and leave the
+ * output zeroed, as reading a closed stream did.
+ */
+
+static inline const guint8 *hwp_hwp3_parser_take (HwpHWP3Parser *parser,
+                                                  gsize          count)
 {
-  g_return_val_if_fail (parser != NULL, FALSE);
+  const guint8 *p = parser->pos;
 
-  gboolean is_success = FALSE;
-  is_success = g_input_stream_read_all (parser->stream, buffer, count,
-                                        &parser->bytes_read,
-                                        NULL, NULL);
-  if ((is_success == FALSE) || (parser->bytes_read == 0))
+  if (G_UNLIKELY ((gsize) (parser->end - p) < count))
   {
-    g_input_stream_close (parser->stream, NULL, NULL);
-    return FALSE;
+    parser->bytes_read = parser->end - p;
+    parser->pos        = parser->end;
+    return NULL;
   }
 
-  return TRUE;
+  parser->bytes_read = count;
+  parser->pos       += count;
+
+  return p;
 }
 
-gboolean hwp_hwp3_parser_read_uint8 (HwpHWP3Parser *parser, guint8 *i)
+static inline gboolean hwp_hwp3_parser_read_uint8 (HwpHWP3Parser *parser,
+                                                   guint8        *i)
 {
-  g_return_val_if_fail (parser != NULL, FALSE);
+  const guint8 *p = hwp_hwp3_parser_take (parser, 1);
 
-  gboolean is_success = FALSE;
-  is_success = g_input_stream_read_all (parser->stream, i, 1,
-                                        &parser->bytes_read,
-                                        NULL, NULL);
-  if ((is_success == FALSE) || (parser->bytes_read != 1))
-  {
-    *i = 0;
-    g_input_stream_close (parser->stream, NULL, NULL);
-    return FALSE;
-  }
+  *i = p ? p[0] : 0;
 
-  return TRUE;
+  return p != NULL;
 }
 
-gboolean hwp_hwp3_parser_read_uint16 (HwpHWP3Parser *parser, guint16 *i)
+static inline gboolean hwp_hwp3_parser_read_uint16 (HwpHWP3Parser *parser,
+                                                    guint16       *i)
 {
-  g_return_val_if_fail (parser != NULL, FALSE);
+  const guint8 *p = hwp_hwp3_parser_take (parser, 2);
 
-  gboolean is_success = FALSE;
-  is_success = g_input_stream_read_all (parser->stream, i, 2,
-                                        &parser->bytes_read,
-                                        NULL, NULL);
-  if ((is_success == FALSE) || (parser->bytes_read != 2))
-  {
-    *i = 0;
-    g_input_stream_close (parser->stream, NULL, NULL);
-    return FALSE;
-  }
-  *i = GUINT16_FROM_LE(*i);
+  *i = p ? (guint16) (p[0] | p[1] << 8) : 0;
 
-  return TRUE;
+  return p != NULL;
 }
 
-gboolean hwp_hwp3_parser_read_uint32 (HwpHWP3Parser *parser, guint32 *i)
+static inline gboolean hwp_hwp3_parser_read_uint32 (HwpHWP3Parser *parser,
+                                                    guint32       *i)
 {
-  g_return_val_if_fail (parser != NULL, FALSE);
+  const guint8 *p = hwp_hwp3_parser_take (parser, 4);
 
-  gboolean is_success = FALSE;
-  is_success = g_input_stream_read_all (parser->stream, i, 4,
-                                        &parser->bytes_read,
-                                        NULL, NULL);
-  if ((is_success == FALSE) || (parser->bytes_read != 4))
-  {
-    *i = 0;
-    g_input_stream_close (parser->stream, NULL, NULL);
-    return FALSE;
-  }
-  *i = GUINT32_FROM_LE(*i);
+  *i = p ? (guint32) p[0]       | (guint32) p[1] << 8 |
+           (guint32) p[2] << 16 | (guint32) p[3] << 24 : 0;
 
-  return TRUE;
+  return p != NULL;
 }
 
-gboolean hwp_hwp3_parser_skip (HwpHWP3Parser *parser, guint16 count)
+static inline gboolean hwp_hwp3_parser_skip (HwpHWP3Parser *parser,
+                                             gsize          count)
 {
-  g_return_val_if_fail (parser != NULL, FALSE);
-
-  if (G_UNLIKELY (count == 0))
-    return TRUE;
-
-  gboolean is_success = FALSE;
-  guint8  *buf        = g_malloc (count);
-
-  is_success = g_input_stream_read_all (parser->stream, buf, (gsize) count,
-                                        &parser->bytes_read,
-                                        NULL, NULL);
-  g_free (buf);
-
-  if ((is_success == FALSE) || (parser->bytes_read != (gsize) count))
+  if (G_UNLIKELY (!hwp_hwp3_parser_take (parser, count)))
   {
     g_warning ("%s:%d:skip size mismatch\n", __FILE__, __LINE__);
-    g_input_stream_close (parser->stream, NULL, NULL);
     return FALSE;
   }
 
   return TRUE;
 }
 
+static void hwp_hwp3_parser_set_buffer (HwpHWP3Parser *parser,
+                                        GBytes        *bytes)
+{
+  gsize len;
+
+  if (parser->buffer)
+    g_bytes_unref (parser->buffer);
+
+  parser->buffer = bytes;
+  parser->pos    = g_bytes_get_data (bytes, &len);
+  parser->end    = parser->pos + len;
+}
+
 static void _hwp_hwp3_parser_parse_signature (HwpHWP3Parser *parser,
                                               HwpHWP3File   *file,
                                               GError       **error)
 {
   g_return_if_fail (HWP_IS_HWP3_PARSER (parser));
-  gchar *signature = g_malloc(30);
-  hwp_hwp3_parser_read (parser, signature, 30);
-  g_free (signature);
+  hwp_hwp3_parser_skip (parser, 30);
 }
 
 static void _hwp_hwp3_parser_parse_doc_info (HwpHWP3Parser *parser,
@@ -217,12 +200,7 @@ static void _hwp_hwp3_parser_parse_summary_info (HwpHWP3Parser *parser,
 
       if (G_LIKELY (c != 0))
       {
-        gchar *str = hwp_hnchar_to_utf8 (c);
-
-        if (str)
-          g_string_append (string[i], str);
-
-        g_free (str);
+        hwp_hnchar_append_utf8 (c, string[i]);
       }
       else
       {
@@ -300,8 +278,7 @@ static void _hwp_hwp3_parser_parse_info_block (HwpHWP3Parser *parser,
 {
   g_return_if_fail (HWP_IS_HWP3_FILE (file));
 
-  GInputStream *stream = file->priv->stream;
-  g_input_stream_skip (stream, file->info_block_len, NULL, error);
+  hwp_hwp3_parser_skip (parser, file->info_block_len);
 }
 
 static void _hwp_hwp3_parser_parse_font_names (HwpHWP3Parser *parser,
@@ -310,18 +287,19 @@ static void _hwp_hwp3_parser_parse_font_names (HwpHWP3Parser *parser,
 {
   g_return_if_fail (HWP_IS_HWP3_FILE (file));
   guint16 n_fonts;
-  gchar *buffer = NULL;
-  gsize bytes_read;
-  GInputStream *stream = HWP_HWP3_FILE (file)->priv->stream;
+  const guint8 *buffer;
 
   for (guint8 i = 0; i < 7; i++)
   {
-    g_input_stream_read_all (stream, &n_fonts, 2, &bytes_read, NULL, NULL);
-    buffer = g_malloc (40 * n_fonts);
-    g_input_stream_read_all (stream, buffer, 40 * n_fonts, &bytes_read, NULL, NULL);
-    gchar *fontname = g_convert (buffer, bytes_read, "UTF-8", "JOHAB",
-                                 NULL, NULL, error);
-    g_free (buffer);
+    hwp_hwp3_parser_read_uint16 (parser, &n_fonts);
+    buffer = hwp_hwp3_parser_take (parser, 40 * n_fonts);
+    if (!buffer)
+      return;
+
+    /* 버퍼에서 바로 변환한다; 이름은 쓰지 않으므로 변환 오류는
+     * 본문 파싱을 멈추지 않게 버린다 */
+    gchar *fontname = g_convert ((const gchar *) buffer, 40 * n_fonts,
+                                 "UTF-8", "JOHAB", NULL, NULL, NULL);
     g_free (fontname);
   }
 }
@@ -332,18 +310,18 @@ static void _hwp_hwp3_parser_parse_styles (HwpHWP3Parser *parser,
 {
   g_return_if_fail (HWP_IS_HWP3_FILE (file));
   guint16 n_styles;
-  gchar *buffer = NULL;
-  gsize bytes_read;
-  GInputStream *stream = HWP_HWP3_FILE (file)->priv->stream;
-  g_input_stream_read_all (stream, &n_styles, 2, &bytes_read, NULL, error);
+  const guint8 *buffer;
+
+  hwp_hwp3_parser_read_uint16 (parser, &n_styles);
 
   for (guint16 i = 0; i < n_styles; i++)
   {
-    buffer = g_malloc (20 + 31 + 187);
-    g_input_stream_read_all (stream, buffer, 20 + 31 + 187, &bytes_read, NULL, error);
-    gchar *stylename = g_convert (buffer, 20, "UTF-8", "JOHAB",
-                                  NULL, NULL, error);
-    g_free (buffer);
+    buffer = hwp_hwp3_parser_take (parser, 20 + 31 + 187);
+    if (!buffer)
+      return;
+
+    gchar *stylename = g_convert ((const gchar *) buffer, 20,
+                                  "UTF-8", "JOHAB", NULL, NULL, NULL);
     g_free (stylename);
   }
 }
@@ -354,6 +332,11 @@ static gboolean _hwp_hwp3_parser_parse_paragraph (HwpHWP3Parser *parser,
 {
   g_return_val_if_fail (HWP_IS_HWP3_FILE (file), FALSE);
 
+  /* 중첩된 문단 리스트도 오류나 취소 뒤에는 바로 끝낸다 */
+  if (*error ||
+      g_cancellable_set_error_if_cancelled (parser->cancellable, error))
+    return FALSE;
+
   /* 문단 정보 */
   guint8  prev_paragraph_shape;
   guint16 n_chars;
@@ -391,7 +374,7 @@ static gboolean _hwp_hwp3_parser_parse_paragraph (HwpHWP3Parser *parser,
   }
 
   HwpParagraph *paragraph = hwp_paragraph_new ();
-  GString      *string    = g_string_new ("");
+  GString      *string    = g_string_sized_new (n_chars * 3 + 1);
 
   HwpListenableInterface *iface;
   iface = HWP_LISTENABLE_GET_IFACE (parser->listenable);
@@ -492,12 +475,7 @@ static gboolean _hwp_hwp3_parser_parse_paragraph (HwpHWP3Parser *parser,
       hwp_hwp3_parser_skip (parser, 2);
       continue;
     } else if (c >= 0x0020 && c <= 0xffff) {
-      gchar *tmp = hwp_hnchar_to_utf8 (c);
-
-      if (tmp)
-        g_string_append (string, tmp);
-
-      g_free (tmp);
+      hwp_hnchar_append_utf8 (c, string);
       continue;
     } else {
       g_warning ("special character: %04x", c);
@@ -540,47 +518,85 @@ static void _hwp_hwp3_parser_parse_supplementary_info_block2 (HwpHWP3Parser *par
   g_return_if_fail (HWP_IS_HWP3_FILE (file));
 }
 
-/**
- * hwp_hwp3_parser_parse:
- * @parser: a #HwpHWP3Parser
- * @file: a #HwpHWP3File
- * @error: a #GError
- *
- * Since: 0.0.1
- */
-void hwp_hwp3_parser_parse (HwpHWP3Parser *parser,
-                            HwpHWP3File   *file,
-                            GError       **error)
+/* @error must not be %NULL */
+static void hwp3_parser_parse (HwpHWP3Parser *parser,
+                               HwpHWP3File   *file,
+                               GError       **error)
 {
-  g_return_if_fail (HWP_IS_HWP3_FILE (file));
+  GBytes *bytes;
+  gsize   max_len       = G_MAXSIZE;
+  GError *inflate_error = NULL;
+
+  /* 요약 정보 뒤로는 본문이므로 읽지 않는다 */
+  if (parser->flags & HWP_PARSE_FLAGS_METADATA_ONLY)
+    max_len = 30 + 128 + 1008;
 
-  parser->stream = file->priv->stream;
+  bytes = _hwp_hwp3_file_get_bytes (file, max_len, error);
+  if (!bytes)
+    return;
+
+  hwp_hwp3_parser_set_buffer (parser, bytes);
 
   _hwp_hwp3_parser_parse_signature (parser, file, error);
   _hwp_hwp3_parser_parse_doc_info (parser, file, error);
   _hwp_hwp3_parser_parse_summary_info (parser, file, error);
+
+  if (parser->flags & HWP_PARSE_FLAGS_METADATA_ONLY)
+    goto FINALLY;
+
   _hwp_hwp3_parser_parse_info_block (parser, file, error);
 
+  /* 본문은 한 번에 풀어서 버퍼를 바꾼다. 손상된 본문은 손상 지점
+   * 앞까지 풀린 문단이라도 알리고, 오류는 그 뒤에 돌려준다 */
   if (file->is_compress) {
-    GZlibDecompressor *zd;
-    GInputStream      *cis;
-
-    zd  = g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW);
-    cis = g_converter_input_stream_new (file->priv->stream, G_CONVERTER (zd));
-    g_filter_input_stream_set_close_base_stream (G_FILTER_INPUT_STREAM (cis),
-                                                 TRUE);
-    g_object_unref (file->priv->stream);
-    file->priv->stream = g_object_ref (cis);
-    g_object_unref (zd);
-  }
+    bytes = _hwp_inflate_raw (parser->pos, parser->end - parser->pos, 0,
+                              0, &inflate_error);
+    if (!bytes)
+      bytes = _hwp_inflate_raw_partial (parser->pos,
+                                        parser->end - parser->pos);
 
-  parser->stream = file->priv->stream;
+    hwp_hwp3_parser_set_buffer (parser, bytes);
+  }
 
   _hwp_hwp3_parser_parse_font_names (parser, file, error);
   _hwp_hwp3_parser_parse_styles (parser, file, error);
   _hwp_hwp3_parser_parse_paragraphs (parser, file, error);
   _hwp_hwp3_parser_parse_supplementary_info_block1 (parser, file, error);
   _hwp_hwp3_parser_parse_supplementary_info_block2 (parser, file, error);
+
+  if (inflate_error && *error)
+    g_error_free (inflate_error);
+  else if (inflate_error)
+    g_propagate_error (error, inflate_error);
+
+  FINALLY:
+
+  g_bytes_unref (parser->buffer);
+  parser->buffer = NULL;
+  parser->pos    = NULL;
+  parser->end    = NULL;
+}
+
+/**
+ * hwp_hwp3_parser_parse:
+ * @parser: a #HwpHWP3Parser
+ * @file: a #HwpHWP3File
+ * @error: a #GError
+ *
+ * Since: 0.0.1
+ */
+void hwp_hwp3_parser_parse (HwpHWP3Parser *parser,
+                            HwpHWP3File   *file,
+                            GError       **error)
+{
+  g_return_if_fail (HWP_IS_HWP3_FILE (file));
+
+  GError *tmp_error = NULL;
+
+  hwp3_parser_parse (parser, file, &tmp_error);
+
+  if (tmp_error)
+    g_propagate_error (error, tmp_error);
 }
 
 /**
@@ -609,7 +625,9 @@ static void hwp_hwp3_parser_init (HwpHWP3Parser *parser)
 static void hwp_hwp3_parser_finalize (GObject *object)
 {
   HwpHWP3Parser *parser = HWP_HWP3_PARSER (object);
-  g_object_unref (parser->stream);
+
+  if (parser->buffer)
+    g_bytes_unref (parser->buffer);
 
   G_OBJECT_CLASS (hwp_hwp3_parser_parent_class)->finalize (object);
 }
@@ -44,6 +44,7 @@
 
 #include <glib-object.h>
 #include <gio/gio.h>
+#include "hwp-enums.h"
 #include "hwp-listenable.h"
 #include "hwp-hwp3-file.h"
 
@@ -65,9 +66,14 @@ struct _HwpHWP3Parser
   GObject        parent_instance;
 
   HwpListenable *listenable;
-  GInputStream  *stream;
+  GBytes        *buffer;
+  const guint8  *pos;
+  const guint8  *end;
   gsize          bytes_read;
   gpointer       user_data;
+  HwpParseFlags  flags;
+  /* checked between paragraphs; not referenced */
+  GCancellable  *cancellable;
 };
 
 /**
@@ -42,15 +42,18 @@
  * 한글과컴퓨터의 한/글 문서 파일(.hwp) 공개 문서를 참고하여 개발하였습니다.
  */
 
+#include <string.h>
 #include <gsf/gsf-input-gio.h>
 #include <gsf/gsf-input-memory.h>
 #include <gsf/gsf-input-stdio.h>
 #include <gsf/gsf-utils.h>
-#include <openssl/evp.h>
 
 #include "gsf-input-stream.h"
+#include "hwp-aes-decryptor.h"
+#include "hwp-file-private.h"
 #include "hwp-hwp5-file.h"
 #include "hwp-hwp5-parser.h"
+#include "hwp-inflate.h"
 #include "hwp-models.h"
 
 G_DEFINE_TYPE (HwpHWP5File, hwp_hwp5_file, HWP_TYPE_FILE);
@@ -170,17 +173,468 @@ static void parse_file_header (HwpHWP5File *file)
   file->is_ccl                 = prop & (1 << 11);
 }
 
-static guint32 random_seed = 1;
+/* MSVC rand() 와 같은 수열; 상태는 호출자가 가지므로 재진입 가능하다 */
+static int msvc_rand (guint32 *state)
+{
+  *state = (*state * 214013 + 2531011) & 0xffffffff;
+  return ((*state >> 16) & 0x7fff);
+}
+
+/* wraps @input into a GInputStream, inflating it incrementally if the
+ * document is compressed; the caller keeps its reference to @input */
+static GInputStream *make_converter_stream (GsfInput *input,
+                                            gboolean  is_compress)
+{
+  GInputStream      *gis;
+  GZlibDecompressor *zd;
+  GInputStream      *cis;
+
+  gis = (GInputStream *) gsf_input_stream_new (input);
+
+  if (!is_compress)
+    return gis;
+
+  zd  = g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW);
+  cis = g_converter_input_stream_new (gis, (GConverter *) zd);
+  g_filter_input_stream_set_close_base_stream (G_FILTER_INPUT_STREAM (cis), TRUE);
+  g_object_unref (zd);
+  g_object_unref (gis);
+
+  return cis;
+}
+
+/* like make_converter_stream(), but a compressed stream of bounded size is
+ * inflated in one go into a single buffer, read through a memory stream */
+static GInputStream *make_input_stream (GsfInput *input, gboolean is_compress)
+{
+  gsf_off_t     size = gsf_input_size (input);
+  const guint8 *data;
+  GBytes       *bytes;
+
+  if (!is_compress || size > HWP_INFLATE_WHOLE_MAX)
+    return make_converter_stream (input, is_compress);
+
+  if (size > 0 && (data = gsf_input_read (input, size, NULL)))
+  {
+    if ((bytes = _hwp_inflate_raw (data, size, 0, 0, NULL)))
+    {
+      GInputStream *stream = g_memory_input_stream_new_from_bytes (bytes);
+      g_bytes_unref (bytes);
+      return stream;
+    }
+  }
+
+  /* 손상된 스트림: 손상 지점 앞까지라도 읽을 수 있게 스트리밍으로 푼다 */
+  gsf_input_seek (input, 0, G_SEEK_SET);
+
+  return make_converter_stream (input, is_compress);
+}
+
+/* 배포용 문서: ViewText 섹션 앞 4+256 바이트에서 AES 키를 꺼낸다.
+ * 나머지 암호화된 데이터는 읽지 않고, @section 은 그 시작에 놓인다 */
+static gboolean read_distribute_key (GsfInput *section, guint8 key[16])
+{
+  guint8 data[256];
+
+  if (!gsf_input_read (section, 4, NULL) ||
+      !gsf_input_read (section, 256, data))
+    return FALSE;
+
+  guint32 seed  = GSF_LE_GET_GUINT32 (data);
+  guint32 state = seed;
+  gint n = 0, val = 0, offset;
+
+  for (guint i = 0; i < 256; i++)
+  {
+    if (n == 0)
+    {
+      val = msvc_rand (&state) & 0xff;
+      n = (msvc_rand (&state) & 0xf) + 1;
+    }
+
+    data[i] ^= val;
+
+    n--;
+  }
+
+  offset = 4 + (seed & 0xf);
+  memcpy (key, data + offset, 16);
+#ifdef HWP_ENABLE_DEBUG
+  gchar *sha1 = g_convert ((const gchar *) data + offset, 80,
+                           "UTF-8", "UTF-16LE", NULL, NULL, NULL);
+  printf ("sha1: %s\n", sha1);
+  g_free (sha1);
+#endif
+  memset (data, 0, sizeof data);
+
+  return TRUE;
+}
+
+/* the record stream of a section input; a distribution section is
+ * decrypted block by block as it is read and fed straight to the inflater.
+ * with @streaming, a compressed section is always inflated as it is read */
+static GInputStream *make_section_stream (HwpHWP5File  *file,
+                                          GsfInput     *section,
+                                          const guint8 *key,
+                                          gboolean      streaming)
+{
+  GInputStream *gis;
+  GInputStream *cis;
+  GConverter   *aes;
+
+  if (!file->is_distribute && streaming)
+    return make_converter_stream (section, file->is_compress);
+
+  if (!file->is_distribute)
+    return make_input_stream (section, file->is_compress);
+
+  gis = G_INPUT_STREAM (gsf_input_stream_new (section));
+  aes = _hwp_aes_decryptor_new (key);
+  cis = g_converter_input_stream_new (gis, aes);
+  g_filter_input_stream_set_close_base_stream (G_FILTER_INPUT_STREAM (cis), TRUE);
+  g_object_unref (aes);
+  g_object_unref (gis);
+
+  if (!file->is_compress)
+    return cis;
+
+  gis = cis;
+  aes = (GConverter *) g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW);
+  cis = g_converter_input_stream_new (gis, aes);
+  g_filter_input_stream_set_close_base_stream (G_FILTER_INPUT_STREAM (cis), TRUE);
+  g_object_unref (aes);
+  g_object_unref (gis);
+
+  return cis;
+}
+
+/* looks up the @index-th section; for distribution documents the AES key
+ * is read into @key and the input is left at the encrypted data.
+ * must be called with the file lock held */
+static GsfInput *open_section_input (HwpHWP5File *file,
+                                     guint        index,
+                                     guint8       key[16],
+                                     GError     **error)
+{
+  GsfInput *section;
+  gchar     name[32];
+
+  g_snprintf (name, sizeof name, "Section%u", index);
+  section = gsf_infile_child_by_name (file->priv->body_text, name);
+
+  if (!section || gsf_infile_num_children (GSF_INFILE (section)) != -1)
+  {
+    if (GSF_IS_INPUT (section))
+      g_object_unref (section);
+
+    g_set_error_literal (error,
+                         HWP_FILE_ERROR,
+                         HWP_FILE_ERROR_INVALID,
+                         "invalid hwp file");
+    return NULL;
+  }
+
+  if (file->is_distribute && !read_distribute_key (section, key))
+  {
+    g_object_unref (section);
+    g_set_error_literal (error,
+                         HWP_FILE_ERROR,
+                         HWP_FILE_ERROR_INVALID,
+                         "invalid hwp file");
+    return NULL;
+  }
+
+  return section;
+}
+
+/**
+ * hwp_hwp5_file_get_n_sections:
+ * @file: a #HwpHWP5File
+ *
+ * Returns: the number of body text sections in @file
+ *
+ * Since: 2016.06.01
+ */
+guint hwp_hwp5_file_get_n_sections (HwpHWP5File *file)
+{
+  g_return_val_if_fail (HWP_IS_HWP5_FILE (file), 0);
+
+  return file->section_streams->len;
+}
+
+/**
+ * hwp_hwp5_file_get_section_stream:
+ * @file: a #HwpHWP5File
+ * @index: the index of the section
+ * @error: location to store the error occurring, or %NULL to ignore
+ *
+ * Returns the record stream of the @index-th section.  The stream is
+ * created the first time it is asked for; #HwpHWP5File.section_streams
+ * holds %NULL for sections that have not been accessed yet.  Sections of
+ * distribution documents are decrypted as the stream is read.
+ *
+ * Creating the stream is thread-safe, reading from it is not: the returned
+ * stream reads from the OLE container shared by every section.
+ *
+ * Returns: (transfer none): a #GInputStream, or %NULL on error
+ *
+ * Since: 2016.06.01
+ */
+GInputStream *hwp_hwp5_file_get_section_stream (HwpHWP5File *file,
+                                                guint        index,
+                                                GError     **error)
+{
+  g_return_val_if_fail (HWP_IS_HWP5_FILE (file), NULL);
+  g_return_val_if_fail (index < file->section_streams->len, NULL);
+
+  GInputStream *stream;
+  GsfInput     *section;
+  guint8        key[16];
+
+  g_mutex_lock (&file->priv->lock);
+
+  stream = g_ptr_array_index (file->section_streams, index);
+
+  if (!stream && (section = open_section_input (file, index, key, error)))
+  {
+    stream = make_section_stream (file, section, key, FALSE);
+    g_object_unref (section);
+    g_ptr_array_index (file->section_streams, index) = stream;
+  }
+
+  g_mutex_unlock (&file->priv->lock);
+
+  return stream;
+}
+
+/*
+ * Returns a new, uncached stream of the @index-th section, backed by a
+ * private copy of its raw (still encrypted and compressed) data.  The OLE
+ * input is read under the file lock; decrypting and inflating the returned
+ * stream touches nothing shared, so it may be done on any thread.
+ * With @streaming, the section is inflated as the stream is read instead
+ * of in one go, so that memory stays bounded and inflating overlaps with
+ * decoding the records.
+ */
+GInputStream *_hwp_hwp5_file_open_section (HwpHWP5File *file,
+                                           guint        index,
+                                           gboolean     streaming,
+                                           GError     **error)
+{
+  g_return_val_if_fail (HWP_IS_HWP5_FILE (file), NULL);
+  g_return_val_if_fail (index < file->section_streams->len, NULL);
+
+  GInputStream *stream;
+  GsfInput     *section;
+  GsfInput     *copy;
+  guint8        key[16];
+  gsf_off_t     size;
+  guint8       *data;
+
+  g_mutex_lock (&file->priv->lock);
+
+  section = open_section_input (file, index, key, error);
+
+  if (!section)
+  {
+    g_mutex_unlock (&file->priv->lock);
+    return NULL;
+  }
+
+  /* from the current position: past the key header when distributed */
+  size = gsf_input_remaining (section);
+  data = g_malloc (size);
+
+  if (size > 0 && !gsf_input_read (section, size, data))
+  {
+    g_free (data);
+    g_object_unref (section);
+    g_mutex_unlock (&file->priv->lock);
+    g_set_error_literal (error,
+                         HWP_FILE_ERROR,
+                         HWP_FILE_ERROR_INVALID,
+                         "invalid hwp file");
+    return NULL;
+  }
+
+  copy = gsf_input_memory_new (data, size, TRUE);
+  g_object_unref (section);
+
+  g_mutex_unlock (&file->priv->lock);
+
+  stream = make_section_stream (file, copy, key, streaming);
+  g_object_unref (copy);
+
+  return stream;
+}
+
+/* reads @stream to the end; like _hwp_inflate_raw(), fails rather than
+ * produce more than HWP_INFLATE_OUTPUT_MAX */
+static GBytes *read_stream_bytes (GInputStream *stream, GError **error)
+{
+  GByteArray *array = g_byte_array_new ();
+  guint8      buffer[16384];
+  gssize      len;
+
+  while ((len = g_input_stream_read (stream, buffer, sizeof buffer,
+                                     NULL, error)) > 0)
+  {
+    if (array->len + (gsize) len > HWP_INFLATE_OUTPUT_MAX)
+    {
+      g_byte_array_unref (array);
+      g_set_error_literal (error, HWP_ERROR, HWP_ERROR_INVALID,
+                           "Decompressed data is too large");
+      return NULL;
+    }
+
+    g_byte_array_append (array, buffer, len);
+  }
+
+  if (len < 0)
+  {
+    g_byte_array_unref (array);
+    return NULL;
+  }
+
+  return g_byte_array_free_to_bytes (array);
+}
+
+/* the records of the @index-th section, decrypted and inflated */
+GBytes *_hwp_hwp5_file_read_section (HwpHWP5File *file,
+                                     guint        index,
+                                     GError     **error)
+{
+  GInputStream *stream = _hwp_hwp5_file_open_section (file, index, FALSE,
+                                                      error);
+  GBytes       *bytes;
+
+  if (!stream)
+    return NULL;
+
+  bytes = read_stream_bytes (stream, error);
+  g_object_unref (stream);
 
-static void msvc_srand (guint32 seed)
+  return bytes;
+}
+
+/* the records of DocInfo, inflated; unlike doc_info_stream, which the
+ * parser consumes, this can be called any number of times */
+GBytes *_hwp_hwp5_file_read_doc_info (HwpHWP5File *file, GError **error)
+{
+  g_return_val_if_fail (HWP_IS_HWP5_FILE (file), NULL);
+
+  GsfInput *input;
+  gsf_off_t size;
+  guint8   *data;
+  GBytes   *bytes;
+
+  g_mutex_lock (&file->priv->lock);
+
+  input = gsf_infile_child_by_name (GSF_INFILE (file->priv->olefile),
+                                    "DocInfo");
+  if (!input)
+  {
+    g_mutex_unlock (&file->priv->lock);
+    g_set_error_literal (error, HWP_FILE_ERROR, HWP_FILE_ERROR_INVALID,
+                         "invalid hwp file");
+    return NULL;
+  }
+
+  size = gsf_input_size (input);
+  data = g_malloc (size);
+
+  if (size > 0 && !gsf_input_read (input, size, data))
+  {
+    g_free (data);
+    g_object_unref (input);
+    g_mutex_unlock (&file->priv->lock);
+    g_set_error_literal (error, HWP_FILE_ERROR, HWP_FILE_ERROR_INVALID,
+                         "invalid hwp file");
+    return NULL;
+  }
+
+  g_object_unref (input);
+  g_mutex_unlock (&file->priv->lock);
+
+  if (!file->is_compress)
+    return g_bytes_new_take (data, size);
+
+  bytes = _hwp_inflate_raw (data, size, 0, 0, error);
+  g_free (data);
+
+  return bytes;
+}
+
+/**
+ * hwp_hwp5_file_get_n_bin_data:
+ * @file: a #HwpHWP5File
+ *
+ * Returns: the number of BinData entries in @file
+ *
+ * Since: 2016.06.01
+ */
+guint hwp_hwp5_file_get_n_bin_data (HwpHWP5File *file)
 {
-  random_seed = seed;
+  g_return_val_if_fail (HWP_IS_HWP5_FILE (file), 0);
+
+  return file->bin_data_streams->len;
 }
 
-static int msvc_rand ()
+/**
+ * hwp_hwp5_file_get_bin_data_stream:
+ * @file: a #HwpHWP5File
+ * @index: the index of the BinData entry
+ * @error: location to store the error occurring, or %NULL to ignore
+ *
+ * Returns the stream of the @index-th BinData entry, creating it on first
+ * access; #HwpHWP5File.bin_data_streams holds %NULL for entries that have
+ * not been accessed yet.
+ *
+ * Returns: (transfer none): a #GInputStream, or %NULL on error
+ *
+ * Since: 2016.06.01
+ */
+GInputStream *hwp_hwp5_file_get_bin_data_stream (HwpHWP5File *file,
+                                                 guint        index,
+                                                 GError     **error)
 {
-  random_seed = (random_seed * 214013 + 2531011) & 0xffffffff;
-  return ((random_seed >> 16) & 0x7fff);
+  g_return_val_if_fail (HWP_IS_HWP5_FILE (file), NULL);
+  g_return_val_if_fail (index < file->bin_data_streams->len, NULL);
+
+  GInputStream *stream;
+  GsfInput     *bin_data_input;
+
+  g_mutex_lock (&file->priv->lock);
+
+  stream = g_ptr_array_index (file->bin_data_streams, index);
+
+  if (stream)
+    goto OUT;
+
+  bin_data_input = gsf_infile_child_by_index (file->priv->bin_data, index);
+
+  if (!bin_data_input ||
+      gsf_infile_num_children (GSF_INFILE (bin_data_input)) != -1)
+  {
+    if (GSF_IS_INPUT (bin_data_input))
+      g_object_unref (bin_data_input);
+
+    g_set_error_literal (error,
+                         HWP_FILE_ERROR,
+                         HWP_FILE_ERROR_INVALID,
+                         "invalid hwp file");
+    goto OUT;
+  }
+
+  stream = make_input_stream (bin_data_input, file->is_compress);
+  g_object_unref (bin_data_input);
+  g_ptr_array_index (file->bin_data_streams, index) = stream;
+
+  OUT:
+
+  g_mutex_unlock (&file->priv->lock);
+
+  return stream;
 }
 
 static void make_stream (HwpHWP5File *file, GError **error)
@@ -214,27 +668,10 @@ static void make_stream (HwpHWP5File *file, GError **error)
   input = gsf_infile_child_by_name (ole, "DocInfo");
   if (input && gsf_infile_num_children (GSF_INFILE (input)) == -1)
   {
-    if (file->is_compress)
-    {
-      GInputStream      *gis;
-      GZlibDecompressor *zd;
-      GInputStream      *cis;
-
-      gis = (GInputStream *) gsf_input_stream_new (input);
-      zd  = g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW);
-      cis = g_converter_input_stream_new (gis, (GConverter *)   zd);
-      g_filter_input_stream_set_close_base_stream (G_FILTER_INPUT_STREAM (cis), TRUE);
-      file->doc_info_stream = cis;
-
-      g_object_unref (zd);
-      g_object_unref (gis);
-
-      input = NULL;
-    }
-    else
-    {
-      file->doc_info_stream = (GInputStream *) gsf_input_stream_new (input);
-    }
+    /* 파일을 열 때 DocInfo 전체를 풀지 않는다 */
+    file->doc_info_stream = make_converter_stream (input, file->is_compress);
+    g_object_unref (input);
+    input = NULL;
   }
   else
   {
@@ -248,103 +685,10 @@ static void make_stream (HwpHWP5File *file, GError **error)
 
   if (input)
   {
-    for (gint i = 0; i < gsf_infile_num_children (GSF_INFILE (input)); i++)
-    {
-      GsfInput *section =
-                  gsf_infile_child_by_name (GSF_INFILE (input),
-                                            g_strdup_printf("Section%d", i));
-
-      if (gsf_infile_num_children (GSF_INFILE (section)) != -1)
-      {
-        if (GSF_IS_INPUT (section))
-          g_object_unref (section);
-
-        g_set_error_literal (error,
-                             HWP_FILE_ERROR,
-                             HWP_FILE_ERROR_INVALID,
-                             "invalid hwp file");
-        return;
-      }
-
-      if (file->is_distribute)
-      {
-        guint8 *data = g_malloc0 (256);
-        gsf_input_read (section, 4, NULL);
-        gsf_input_read (section, 256, data);
-        guint32 seed = GSF_LE_GET_GUINT32 (data);
-        msvc_srand (seed);
-        gint n = 0, val = 0, offset;
-
-        for (guint i = 0; i < 256; i++)
-        {
-          if (n == 0)
-          {
-            val = msvc_rand() & 0xff;
-            n = (msvc_rand() & 0xf) + 1;
-          }
-
-          data[i] ^= val;
-
-          n--;
-        }
-
-        offset = 4 + (seed & 0xf);
-        gchar *key = g_memdup (data + offset, 16);
-#ifdef HWP_ENABLE_DEBUG
-        gchar *sha1 = g_convert ((const gchar *) data + offset, 80,
-                                 "UTF-8", "UTF-16LE", NULL, NULL, error);
-        printf ("sha1: %s\n", sha1);
-        printf ("key: %s\n", key);
-        g_free (sha1);
-#endif
-        g_free (data);
-
-        EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new ();
-        EVP_CIPHER_CTX_init (ctx);
-        EVP_DecryptInit_ex (ctx, EVP_aes_128_ecb(), NULL,
-                            (unsigned char *) key, NULL);
-        g_free (key);
-        EVP_CIPHER_CTX_set_padding(ctx, 0); /* no padding */
-
-        gsf_off_t encrypted_data_len = gsf_input_remaining (section);
-        guint8 const *encrypted_data = gsf_input_read (section, encrypted_data_len, NULL);
-
-        guint8 *decrypted_data = g_malloc (encrypted_data_len);
-        int decrypted_data_len, len;
-
-        EVP_DecryptUpdate (ctx, decrypted_data, &len, encrypted_data, encrypted_data_len);
-        decrypted_data_len = len;
-
-        EVP_DecryptFinal_ex (ctx, decrypted_data + len, &len);
-        decrypted_data_len += len;
-
-        EVP_CIPHER_CTX_free (ctx);
-        g_object_unref (section);
-
-        section = gsf_input_memory_new (decrypted_data, decrypted_data_len, TRUE);
-      }
-
-      if (file->is_compress)
-      {
-        GInputStream      *gis;
-        GZlibDecompressor *zd;
-        GInputStream      *cis;
-
-        gis = (GInputStream *) gsf_input_stream_new (section);
-        zd  = g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW);
-        cis = g_converter_input_stream_new (gis, (GConverter *) zd);
-        g_filter_input_stream_set_close_base_stream (G_FILTER_INPUT_STREAM (cis), TRUE);
-        g_ptr_array_add (file->section_streams, cis);
-        g_object_unref (zd);
-        g_object_unref (gis);
-      }
-      else
-      {
-        GInputStream *stream = (GInputStream *) gsf_input_stream_new (section);
-        g_ptr_array_add (file->section_streams, stream);
-      }
-    } /* for */
-    g_object_unref (input);
+    /* 섹션 스트림은 hwp_hwp5_file_get_section_stream() 에서 만든다 */
+    gint n_sections = gsf_infile_num_children (GSF_INFILE (input));
+    g_ptr_array_set_size (file->section_streams, MAX (n_sections, 0));
+    file->priv->body_text = GSF_INFILE (input);
     input = NULL;
   }
   else
@@ -368,46 +712,8 @@ static void make_stream (HwpHWP5File *file, GError **error)
   if (input)
   {
     gint n_data = gsf_infile_num_children (GSF_INFILE (input));
-
-    for (gint i = 0; i < n_data; i++)
-    {
-      GsfInput *bin_data_input =
-                  gsf_infile_child_by_index (GSF_INFILE (input), i);
-
-      if (gsf_infile_num_children (GSF_INFILE (bin_data_input)) != -1)
-      {
-        if (GSF_IS_INPUT (bin_data_input))
-          g_object_unref (bin_data_input);
-
-        g_set_error_literal (error,
-                             HWP_FILE_ERROR,
-                             HWP_FILE_ERROR_INVALID,
-                             "invalid hwp file");
-        return;
-      }
-
-      if (file->is_compress)
-      {
-        GInputStream      *gis;
-        GZlibDecompressor *zd;
-        GInputStream      *cis;
-
-        gis = (GInputStream *) gsf_input_stream_new (bin_data_input);
-        zd  = g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW);
-        cis = g_converter_input_stream_new (gis, (GConverter *) zd);
-        g_filter_input_stream_set_close_base_stream (G_FILTER_INPUT_STREAM (cis), TRUE);
-        g_ptr_array_add (file->bin_data_streams, cis);
-        g_object_unref (zd);
-        g_object_unref (gis);
-      }
-      else
-      {
-        GInputStream *stream = (GInputStream *) gsf_input_stream_new (bin_data_input);
-        g_ptr_array_add (file->bin_data_streams, stream);
-      }
-    }
-
-    g_object_unref (input);
+    g_ptr_array_set_size (file->bin_data_streams, MAX (n_data, 0));
+    file->priv->bin_data = GSF_INFILE (input);
     input = NULL;
   }
 
@@ -447,6 +753,21 @@ static void make_stream (HwpHWP5File *file, GError **error)
   return;
 }
 
+HwpHWP5File *_hwp_hwp5_file_new_for_gsf_input (GsfInput *input,
+                                              GError  **error)
+{
+  GsfInfile *olefile;
+
+  if ((olefile = gsf_infile_msole_new (input, error))) {
+    HwpHWP5File *file   = g_object_new (HWP_TYPE_HWP5_FILE, NULL);
+    file->priv->olefile = olefile;
+    make_stream (file, error);
+    return file;
+  }
+
+  return NULL;
+}
+
 /**
  * hwp_hwp5_file_new_for_path:
  * @path: path of the file to load
@@ -464,25 +785,18 @@ HwpHWP5File *hwp_hwp5_file_new_for_path (const gchar *path, GError **error)
 {
   g_return_val_if_fail (path != NULL, NULL);
 
-  GsfInput  *input;
-  GsfInfile *olefile;
+  GsfInput    *input;
+  HwpHWP5File *file = NULL;
 
   if ((input = gsf_input_stdio_new (path, error))) {
-    if ((olefile = gsf_infile_msole_new (input, error))) {
-      HwpHWP5File *file   = g_object_new (HWP_TYPE_HWP5_FILE, NULL);
-      file->priv->olefile = olefile;
-      g_object_unref (input);
-      make_stream (file, error);
-      return file;
-    }
+    file = _hwp_hwp5_file_new_for_gsf_input (input, error);
+    g_object_unref (input);
   }
 
-  g_warning (G_STRLOC ": %s: %s", G_STRFUNC, (*error)->message);
-
-  if (input)
-    g_object_unref (input);
+  if (!file)
+    g_warning (G_STRLOC ": %s: %s", G_STRFUNC, (*error)->message);
 
-  return NULL;
+  return file;
 }
 
 /**
@@ -502,25 +816,56 @@ HwpHWP5File *hwp_hwp5_file_new_for_uri (const gchar *uri, GError **error)
 {
   g_return_val_if_fail (uri != NULL, NULL);
 
-  GsfInput  *input;
-  GsfInfile *olefile;
+  GsfInput    *input;
+  HwpHWP5File *file = NULL;
 
   if ((input = gsf_input_gio_new_for_uri (uri, error))) {
-    if ((olefile = gsf_infile_msole_new (input, error))) {
-      HwpHWP5File *file   = g_object_new (HWP_TYPE_HWP5_FILE, NULL);
-      file->priv->olefile = olefile;
-      g_object_unref (input);
-      make_stream (file, error);
-      return file;
-    }
+    file = _hwp_hwp5_file_new_for_gsf_input (input, error);
+    g_object_unref (input);
   }
 
-  g_warning (G_STRLOC ": %s: %s", G_STRFUNC, (*error)->message);
+  if (!file)
+    g_warning (G_STRLOC ": %s: %s", G_STRFUNC, (*error)->message);
 
-  if (input)
-    g_object_unref (input);
+  return file;
+}
 
-  return NULL;
+/**
+ * hwp_hwp5_file_new_for_bytes:
+ * @bytes: a #GBytes containing the whole document
+ * @error: location to store the error occurring, or %NULL to ignore
+ *
+ * Creates a new #HwpHWP5File which reads the document directly from
+ * @bytes, without copying it. A reference to @bytes is kept for the
+ * lifetime of the returned file. If %NULL is returned, then @error will be
+ * set. Possible errors include those in the #HWP_ERROR and #HWP_FILE_ERROR
+ * domains.
+ *
+ * Returns: A newly created #HwpHWP5File, or %NULL
+ *
+ * Since: 2016.06.01
+ */
+HwpHWP5File *hwp_hwp5_file_new_for_bytes (GBytes *bytes, GError **error)
+{
+  g_return_val_if_fail (bytes != NULL, NULL);
+
+  GsfInput    *input;
+  HwpHWP5File *file;
+  gsize        size;
+  gconstpointer data = g_bytes_get_data (bytes, &size);
+
+  input = gsf_input_memory_new (data, (gsf_off_t) size, FALSE);
+  file  = _hwp_hwp5_file_new_for_gsf_input (input, error);
+  g_object_unref (input);
+
+  if (!file) {
+    g_warning (G_STRLOC ": %s: %s", G_STRFUNC, (*error)->message);
+    return NULL;
+  }
+
+  file->priv->bytes = g_bytes_ref (bytes);
+
+  return file;
 }
 
 static void hwp_hwp5_file_finalize (GObject *object)
@@ -545,11 +890,23 @@ static void hwp_hwp5_file_finalize (GObject *object)
   g_ptr_array_unref (file->section_streams);
   g_ptr_array_unref (file->bin_data_streams);
 
+  if (file->priv->body_text)
+    g_object_unref (file->priv->body_text);
+
+  if (file->priv->bin_data)
+    g_object_unref (file->priv->bin_data);
+
+  g_mutex_clear (&file->priv->lock);
+
   if (file->summary_info_stream)
     g_object_unref (file->summary_info_stream);
 
   g_free (file->signature);
 
+  /* the ole file reads from the bytes, so release them last */
+  if (file->priv->bytes)
+    g_bytes_unref (file->priv->bytes);
+
   G_OBJECT_CLASS (hwp_hwp5_file_parent_class)->finalize (object);
 }
 
@@ -563,12 +920,20 @@ static void hwp_hwp5_file_class_init (HwpHWP5FileClass *klass)
   object_class->finalize = hwp_hwp5_file_finalize;
 }
 
+/* 아직 만들지 않은 스트림 자리는 NULL 이다 */
+static void stream_unref (gpointer stream)
+{
+  if (stream)
+    g_object_unref (stream);
+}
+
 static void hwp_hwp5_file_init (HwpHWP5File *file)
 {
-  file->section_streams  = g_ptr_array_new_with_free_func (g_object_unref);
-  file->bin_data_streams = g_ptr_array_new_with_free_func (g_object_unref);
+  file->section_streams  = g_ptr_array_new_with_free_func (stream_unref);
+  file->bin_data_streams = g_ptr_array_new_with_free_func (stream_unref);
 
   file->priv = G_TYPE_INSTANCE_GET_PRIVATE (file,
                                             HWP_TYPE_HWP5_FILE,
                                             HwpHWP5FilePrivate);
+  g_mutex_init (&file->priv->lock);
 }
@@ -114,24 +114,38 @@ struct _HwpHWP5FileClass
 struct _HwpHWP5FilePrivate
 {
   GsfInfile *olefile;
+  GBytes    *bytes;
+  GsfInfile *body_text;
+  GsfInfile *bin_data;
+  GMutex     lock; /* guards reads from olefile */
 };
 
-GType        hwp_hwp5_file_get_type               (void) G_GNUC_CONST;
-gboolean     hwp_hwp5_file_check_version          (HwpHWP5File *file,
-                                                   guint8       major,
-                                                   guint8       minor,
-                                                   guint8       micro,
-                                                   guint8       extra);
-void         hwp_hwp5_file_get_hwp_version        (HwpFile     *file,
-                                                   guint8      *major_version,
-                                                   guint8      *minor_version,
-                                                   guint8      *micro_version,
-                                                   guint8      *extra_version);
-gchar       *hwp_hwp5_file_get_hwp_version_string (HwpFile     *file);
-HwpHWP5File *hwp_hwp5_file_new_for_path           (const gchar *path,
-                                                   GError     **error);
-HwpHWP5File *hwp_hwp5_file_new_for_uri            (const gchar *uri,
-                                                   GError     **error);
+GType         hwp_hwp5_file_get_type               (void) G_GNUC_CONST;
+gboolean      hwp_hwp5_file_check_version          (HwpHWP5File *file,
+                                                    guint8       major,
+                                                    guint8       minor,
+                                                    guint8       micro,
+                                                    guint8       extra);
+void          hwp_hwp5_file_get_hwp_version        (HwpFile     *file,
+                                                    guint8      *major_version,
+                                                    guint8      *minor_version,
+                                                    guint8      *micro_version,
+                                                    guint8      *extra_version);
+gchar        *hwp_hwp5_file_get_hwp_version_string (HwpFile     *file);
+HwpHWP5File  *hwp_hwp5_file_new_for_path           (const gchar *path,
+                                                    GError     **error);
+HwpHWP5File  *hwp_hwp5_file_new_for_uri            (const gchar *uri,
+                                                    GError     **error);
+HwpHWP5File  *hwp_hwp5_file_new_for_bytes          (GBytes      *bytes,
+                                                    GError     **error);
+guint         hwp_hwp5_file_get_n_sections         (HwpHWP5File *file);
+GInputStream *hwp_hwp5_file_get_section_stream     (HwpHWP5File *file,
+                                                    guint        index,
+                                                    GError     **error);
+guint         hwp_hwp5_file_get_n_bin_data         (HwpHWP5File *file);
+GInputStream *hwp_hwp5_file_get_bin_data_stream    (HwpHWP5File *file,
+                                                    guint        index,
+                                                    GError     **error);
 
 G_END_DECLS
 
@@ -52,8 +52,12 @@
 #include <gsf/gsf-msole-utils.h>
 #include <gsf/gsf-utils.h>
 #include <stdio.h>
+#include <string.h>
+#include "gsf-input-stream.h"
 #include "hwp-hwp5-parser.h"
-#include "hwp-charset.h"
+#include "hwp-file-private.h"
+#include "hwp-pipeline.h"
+#include "hwp-para-text.h"
 
 G_DEFINE_TYPE (HwpHWP5Parser, hwp_hwp5_parser, G_TYPE_OBJECT);
 
@@ -87,20 +91,121 @@ static HwpParagraph *hwp_hwp5_parser_build_paragraph (HwpHWP5Parser *parser,
   } \
 }
 
-gboolean parser_skip (HwpHWP5Parser *parser, guint32 count)
+/* data_len 은 파일에서 온 값이다; 이보다 큰 레코드는 읽지 않는다 */
+#define RECORD_DATA_MAX (64 * 1024 * 1024)
+
+/* 레코드 데이터는 필요할 때 한 번에 읽는다 */
+static gboolean parser_load_data (HwpHWP5Parser *parser, GError **error)
 {
-  gboolean is_success = FALSE;
   gsize bytes_read = 0;
 
-  guint8 *buf = g_malloc (count);
-  is_success = g_input_stream_read_all (parser->stream, buf, count,
-                                        &bytes_read, NULL, NULL);
-  g_free (buf);
+  if (G_LIKELY (parser->data_loaded))
+    return TRUE;
+
+  if (parser->data_len > parser->data_capacity)
+  {
+    gsize   capacity = MAX (parser->data_len, parser->data_capacity * 2);
+    guint8 *data;
+
+    capacity = MIN (capacity, RECORD_DATA_MAX);
+
+    if (parser->data_len > RECORD_DATA_MAX ||
+        !(data = g_try_realloc (parser->data, capacity)))
+    {
+      g_set_error_literal (error, HWP_ERROR, HWP_ERROR_INVALID,
+                           _("File corrupted"));
+      return FALSE;
+    }
+
+    parser->data          = data;
+    parser->data_capacity = capacity;
+  }
+
+  g_input_stream_read_all (parser->stream, parser->data, parser->data_len,
+                           &bytes_read, parser->cancellable, error);
+  if (*error) {
+    g_warning ("%s:%d:%s\n", __FILE__, __LINE__, (*error)->message);
+    return FALSE;
+  }
+  /* 비정상 */
+  if (bytes_read != parser->data_len) {
+    g_set_error_literal (error, HWP_ERROR, HWP_ERROR_INVALID,
+                         _("File corrupted"));
+    return FALSE;
+  }
+
+  parser->data_loaded = TRUE;
+  return TRUE;
+}
+
+/* 건너뛰기가 풀린 바이트 단위로 동작하는 스트림인가;
+ * GConverterInputStream 의 skip 은 압축된 기반 스트림을 건너뛴다 */
+static gboolean stream_skips_decoded (GInputStream *stream)
+{
+  return G_IS_MEMORY_INPUT_STREAM (stream) || GSF_IS_INPUT_STREAM (stream);
+}
+
+/* 읽지 않은 레코드 데이터는 레코드 버퍼에 복사하지 않고 건너뛴다 */
+static gboolean parser_skip_data (HwpHWP5Parser *parser, GError **error)
+{
+  gsize  remaining = parser->data_len;
+  guint8 scratch[4096];
+
+  while (remaining > 0)
+  {
+    gssize skipped;
+
+    if (stream_skips_decoded (parser->stream))
+      skipped = g_input_stream_skip (parser->stream, remaining,
+                                     parser->cancellable, error);
+    else
+      skipped = g_input_stream_read (parser->stream, scratch,
+                                     MIN (remaining, sizeof scratch),
+                                     parser->cancellable, error);
+    if (skipped <= 0)
+    {
+      if (skipped == 0)
+        g_set_error_literal (error, HWP_ERROR, HWP_ERROR_INVALID,
+                             _("File corrupted"));
+      return FALSE;
+    }
+
+    remaining -= skipped;
+  }
 
-  if ((is_success == FALSE) || (bytes_read != count))
+  parser->data_loaded = TRUE;
+  return TRUE;
+}
+
+/* 관심 없는 레코드의 하위 레코드는 디코딩하지 않고 level 로 건너뛴다;
+ * 읽지 않은 레코드 데이터는 다음 pull 이 복사 없이 건너뛴다 */
+static void parser_skip_subtree (HwpHWP5Parser *parser, GError **error)
+{
+  guint16 level = parser->level;
+
+  while (hwp_hwp5_parser_pull (parser, error)) {
+    if (parser->level <= level) {
+      parser->state = HWP_PARSE_STATE_PASSING;
+      break;
+    }
+  }
+}
+
+static void parser_set_stream (HwpHWP5Parser *parser, GInputStream *stream)
+{
+  parser->stream      = stream;
+  parser->data_len    = 0;
+  parser->data_pos    = 0;
+  parser->data_loaded = TRUE;
+}
+
+gboolean parser_skip (HwpHWP5Parser *parser, guint32 count)
+{
+  if (parser->data_pos + count > parser->data_len)
   {
-    g_warning ("%s:%d: count:%d, bytes_read:%" G_GSIZE_FORMAT
-               " skip size mismatch\n", __FILE__, __LINE__, count, bytes_read);
+    g_warning ("%s:%d: count:%d, remained:%d skip size mismatch\n",
+               __FILE__, __LINE__, count, parser->data_len - parser->data_pos);
+    parser->data_pos = parser->data_len;
     return FALSE;
   }
 
@@ -118,18 +223,10 @@ gboolean parser_read_bytes (HwpHWP5Parser *parser,
 #endif
   g_return_val_if_fail (parser->data_pos + count <= parser->data_len, FALSE);
 
-  gboolean is_success = FALSE;
-  gsize bytes_read = 0;
-
-  is_success = g_input_stream_read_all (parser->stream, buffer, count,
-                                        &bytes_read, NULL, NULL);
-
-  if ((is_success == FALSE) || (bytes_read != count))
-  {
-    g_warning ("%s:%d: size mismatch\n", __FILE__, __LINE__);
+  if (!parser_load_data (parser, error))
     return FALSE;
-  }
 
+  memcpy (buffer, parser->data + parser->data_pos, count);
   parser->data_pos += count;
   return TRUE;
 }
@@ -141,14 +238,12 @@ gboolean parser_read_uint8 (HwpHWP5Parser *parser, guint8 *i, GError **error)
 #endif
   g_return_val_if_fail (parser->data_pos + 1 <= parser->data_len, FALSE);
 
-  gsize bytes_read = 0;
-  g_input_stream_read_all (parser->stream, i, 1,
-                           &bytes_read, NULL, error);
-  if (*error || (bytes_read != 1)) {
+  if (!parser_load_data (parser, error)) {
     *i = 0;
     return FALSE;
   }
 
+  *i = parser->data[parser->data_pos];
   parser->data_pos += 1;
   return TRUE;
 }
@@ -160,15 +255,12 @@ gboolean parser_read_uint16 (HwpHWP5Parser *parser, guint16 *i, GError **error)
 #endif
   g_return_val_if_fail (parser->data_pos + 2 <= parser->data_len, FALSE);
 
-  gsize bytes_read = 0;
-  g_input_stream_read_all (parser->stream, i, 2,
-                           &bytes_read, NULL, error);
-  if (*error || (bytes_read != 2)) {
+  if (!parser_load_data (parser, error)) {
     *i = 0;
     return FALSE;
   }
 
-  *i = GUINT16_FROM_LE(*i);
+  *i = GSF_LE_GET_GUINT16 (parser->data + parser->data_pos);
   parser->data_pos += 2;
   return TRUE;
 }
@@ -180,15 +272,12 @@ gboolean parser_read_int16 (HwpHWP5Parser *parser, gint16 *i, GError **error)
 #endif
   g_return_val_if_fail (parser->data_pos + 2 <= parser->data_len, FALSE);
 
-  gsize bytes_read = 0;
-  g_input_stream_read_all (parser->stream, i, 2,
-                           &bytes_read, NULL, error);
-  if (*error || (bytes_read != 2)) {
+  if (!parser_load_data (parser, error)) {
     *i = 0;
     return FALSE;
   }
 
-  *i = GINT16_FROM_LE(*i);
+  *i = GSF_LE_GET_GINT16 (parser->data + parser->data_pos);
   parser->data_pos += 2;
   return TRUE;
 }
@@ -197,14 +286,12 @@ gboolean parser_read_uint32 (HwpHWP5Parser *parser, guint32 *i, GError **error)
 {
   g_return_val_if_fail (parser->data_pos + 4 <= parser->data_len, FALSE);
 
-  gsize bytes_read = 0;
-  g_input_stream_read_all (parser->stream, i, 4,
-                           &bytes_read, NULL, error);
-  if (*error || (bytes_read != 4)) {
+  if (!parser_load_data (parser, error)) {
     *i = 0;
     return FALSE;
   }
-  *i = GUINT32_FROM_LE(*i);
+
+  *i = GSF_LE_GET_GUINT32 (parser->data + parser->data_pos);
   parser->data_pos += 4;
   return TRUE;
 }
@@ -213,14 +300,12 @@ gboolean parser_read_int32 (HwpHWP5Parser *parser, gint32 *i, GError **error)
 {
   g_return_val_if_fail (parser->data_pos + 4 <= parser->data_len, FALSE);
 
-  gsize bytes_read = 0;
-  g_input_stream_read_all (parser->stream, i, 4,
-                           &bytes_read, NULL, error);
-  if (*error || (bytes_read != 4)) {
+  if (!parser_load_data (parser, error)) {
     *i = 0;
     return FALSE;
   }
-  *i = GINT32_FROM_LE(*i);
+
+  *i = GSF_LE_GET_GINT32 (parser->data + parser->data_pos);
   parser->data_pos += 4;
   return TRUE;
 }
@@ -245,6 +330,13 @@ parser_read_color (HwpHWP5Parser *parser, HwpColor *color, GError **error)
  * @parser: #HwpHWP5Parser
  * @error: #GError
  *
+ * Reads the next record header. The payload of the record is read into
+ * @parser->data with a single stream read when the first field is read,
+ * and fields are then read from it without touching the stream.
+ * A payload that was never read is skipped without being copied.
+ * To read payloads directly, without the paragraph model, see
+ * #HwpRecordIter.
+ *
  * On a successful pull, %TRUE is returned.
  *
  * If we reached the end of the stream %FALSE is returned and error is not set.
@@ -265,15 +357,18 @@ gboolean hwp_hwp5_parser_pull (HwpHWP5Parser *parser, GError **error)
     return TRUE;
   }
 
-  if (parser->data_len > parser->data_pos)
-  {
-    parser_skip (parser, parser->data_len - parser->data_pos);
-  }
+  /* 레코드 사이에서 취소를 확인한다; 오류 뒤에는 더 읽지 않는다 */
+  if (*error ||
+      g_cancellable_set_error_if_cancelled (parser->cancellable, error))
+    return FALSE;
+
+  if (!parser->data_loaded && !parser_skip_data (parser, error))
+    return FALSE;
 
   /* 4바이트 읽기 */
   gsize bytes_read = 0;
   g_input_stream_read_all (parser->stream, &parser->header, 4,
-                           &bytes_read, NULL, error);
+                           &bytes_read, parser->cancellable, error);
   if (*error) {
     g_warning ("%s:%d:%s\n", __FILE__, __LINE__, (*error)->message);
     return FALSE;
@@ -301,7 +396,7 @@ gboolean hwp_hwp5_parser_pull (HwpHWP5Parser *parser, GError **error)
   if (parser->data_len == 0xfff)
   {
     g_input_stream_read_all (parser->stream, &parser->data_len, 4,
-                             &bytes_read, NULL, error);
+                             &bytes_read, parser->cancellable, error);
     if (*error) {
       g_warning ("%s:%d:%s\n", __FILE__, __LINE__, (*error)->message);
       return FALSE;
@@ -332,7 +427,8 @@ gboolean hwp_hwp5_parser_pull (HwpHWP5Parser *parser, GError **error)
   }
 #endif
 
-  parser->data_pos = 0;
+  parser->data_pos    = 0;
+  parser->data_loaded = FALSE;
 
   return TRUE;
 
@@ -370,7 +466,7 @@ static void hwp_hwp5_parser_parse_doc_info (HwpHWP5Parser *parser,
   HwpListenableInterface *iface;
   iface = HWP_LISTENABLE_GET_IFACE (parser->listenable);
 
-  parser->stream = file->doc_info_stream;
+  parser_set_stream (parser, file->doc_info_stream);
 
   while (hwp_hwp5_parser_pull (parser, error))
   {
@@ -1206,6 +1302,11 @@ static void hwp_hwp5_parser_parse_ctrl_header (HwpHWP5Parser *parser,
 #endif
   switch (parser->ctrl_id) {
   case CTRL_ID_SECTION_DEF:
+    if (!(parser->events & HWP_EVENT_SECTION_DEFS))
+    {
+      parser_skip_subtree (parser, error);
+      break;
+    }
     {
       HwpSecd *secd = NULL;
       secd = hwp_hwp5_parser_build_section_definition (parser, file, error);
@@ -1218,11 +1319,19 @@ static void hwp_hwp5_parser_parse_ctrl_header (HwpHWP5Parser *parser,
   case CTRL_ID_COLUMN_DEF:
     break;
   case CTRL_ID_HEADEDR: /* 머리말 */
-    hwp_hwp5_parser_parse_header (parser, file, error);
+    if (!(parser->events & HWP_EVENT_NOTES))
+      parser_skip_subtree (parser, error);
+    else
+      hwp_hwp5_parser_parse_header (parser, file, error);
     break;
   case CTRL_ID_AUTO_NUM:
     break;
   case CTRL_ID_TABLE:
+    if (!(parser->events & HWP_EVENT_TABLES))
+    {
+      parser_skip_subtree (parser, error);
+      break;
+    }
     {
       HwpCommonProperty *prop = hwp_common_property_new ();
 
@@ -1254,15 +1363,24 @@ static void hwp_hwp5_parser_parse_ctrl_header (HwpHWP5Parser *parser,
     }
     break;
   case CTRL_ID_FOOTNOTE: /* 각주 */
-    hwp_hwp5_parser_parse_footnote (parser, file, error);
+    if (!(parser->events & HWP_EVENT_NOTES))
+      parser_skip_subtree (parser, error);
+    else
+      hwp_hwp5_parser_parse_footnote (parser, file, error);
     break;
   case CTRL_ID_PAGE_HIDE: /* 페이지 감추기 pghd */
     break;
   case CTRL_ID_DRAWING_SHAPE_OBJECT:
-    hwp_hwp5_parser_parse_shape_component (parser, file, error);
+    if (!(parser->events & HWP_EVENT_SHAPES))
+      parser_skip_subtree (parser, error);
+    else
+      hwp_hwp5_parser_parse_shape_component (parser, file, error);
     break;
   case CTRL_ID_TCMT: /* 숨은 설명 */
-    hwp_hwp5_parser_parse_tcmt (parser, file, error);
+    if (!(parser->events & HWP_EVENT_NOTES))
+      parser_skip_subtree (parser, error);
+    else
+      hwp_hwp5_parser_parse_tcmt (parser, file, error);
     break;
   case CTRL_ID_TCPS:
     break;
@@ -1273,7 +1391,10 @@ static void hwp_hwp5_parser_parse_ctrl_header (HwpHWP5Parser *parser,
     hwp_hwp5_parser_parse_form (parser, file, error);
     break;
   case CTRL_ID_FOOTER:
-    hwp_hwp5_parser_parse_footer (parser, file, error);
+    if (!(parser->events & HWP_EVENT_NOTES))
+      parser_skip_subtree (parser, error);
+    else
+      hwp_hwp5_parser_parse_footer (parser, file, error);
     break;
   case CTRL_ID_BOKM: /* 책갈피 */
     hwp_hwp5_parser_parse_bokm (parser, file, error);
@@ -1298,8 +1419,9 @@ static HwpParagraph *hwp_hwp5_parser_build_paragraph (HwpHWP5Parser *parser,
 {
   guint16 level = parser->level;
 
-  HwpParagraph *paragraph = hwp_paragraph_new ();
-  gchar        *raw_text  = NULL;
+  HwpParagraph *paragraph    = hwp_paragraph_new ();
+  gchar        *raw_text     = NULL;
+  guint32       raw_text_len = 0;
 
   parser_read_uint32 (parser, &paragraph->n_chars, error);
   if (paragraph->n_chars & 0x80000000)
@@ -1330,10 +1452,26 @@ static HwpParagraph *hwp_hwp5_parser_build_paragraph (HwpHWP5Parser *parser,
     switch (parser->tag_id)
     {
       case HWP_TAG_PARA_TEXT:
+        if (parser->flags & HWP_PARSE_FLAGS_TEXT_ONLY)
+        {
+          /* 글자 모양 구간 없이 레코드 버퍼에서 바로 텍스트를 만든다 */
+          if (parser_load_data (parser, error))
+          {
+            guint32  n_units = MIN (paragraph->n_chars, parser->data_len / 2);
+            GString *string  = g_string_sized_new (n_units * 3 + 1);
+
+            _hwp_para_text_append (string, parser->data, n_units);
+            g_free (paragraph->text);
+            paragraph->text = g_string_free (string, FALSE);
+          }
+          break;
+        }
+
         if (raw_text)
           g_free (raw_text);
 
-        raw_text = g_malloc (parser->data_len);
+        raw_text     = g_malloc (parser->data_len);
+        raw_text_len = parser->data_len;
         parser_read_bytes (parser, raw_text, parser->data_len, error);
         parser->data_pos += parser->data_len;
 #ifdef HWP_ENABLE_DEBUG
@@ -1342,11 +1480,20 @@ static HwpParagraph *hwp_hwp5_parser_build_paragraph (HwpHWP5Parser *parser,
 #endif
         break;
       case HWP_TAG_PARA_CHAR_SHAPE:
+        /* 레코드는 읽지 않고 다음 pull 에서 건너뛴다 */
+        if (parser->flags & HWP_PARSE_FLAGS_TEXT_ONLY)
+          break;
         {
+          /* 글자 모양 레코드가 두 번 나오면 뒤의 것을 쓴다 */
+          g_free (paragraph->m_pos);
+          g_free (paragraph->m_id);
+          g_free (paragraph->m_offset);
+          g_free (paragraph->text);
+
           paragraph->m_len = parser->data_len / 8;
           paragraph->m_pos = g_malloc (4 * paragraph->m_len);
           paragraph->m_id  = g_malloc (4 * paragraph->m_len);
-          paragraph->text_attrs = g_ptr_array_new_with_free_func ((GDestroyNotify) hwp_text_attributes_free);
+          paragraph->m_offset = g_malloc (4 * (paragraph->m_len + 1));
 
           for (guint i = 0; i < paragraph->m_len; i++)
           {
@@ -1358,12 +1505,13 @@ static HwpParagraph *hwp_hwp5_parser_build_paragraph (HwpHWP5Parser *parser,
 #endif
           }
 
-          gint prev_index = 0;
-          GString *string = g_string_new ("");
+          /* 문단 텍스트를 버퍼 하나에 이어 쓰고, 글자 모양 구간은
+           * 그 버퍼 안의 바이트 오프셋으로만 기록한다 */
+          GString *string = g_string_sized_new (raw_text_len / 2 * 3 + 1);
+          paragraph->m_offset[0] = 0;
 
           for (guint j = 0; j < paragraph->m_len; j++)
           {
-            GString *substring = g_string_new ("");
             guint32 pos1, pos2;
             pos1 = paragraph->m_pos[j];
 
@@ -1372,94 +1520,23 @@ static HwpParagraph *hwp_hwp5_parser_build_paragraph (HwpHWP5Parser *parser,
             else
               pos2 = paragraph->m_pos[j+1];
 
-            for (guint i = pos1 * 2; i < pos2 * 2; i = i + 2)
-            {
-              if (!raw_text)
-                break;
-
-              gunichar2 c = GSF_LE_GET_GUINT16(raw_text + i);
-              switch (c)
-              {
-                case 0:
-                  break;
-                case 1:
-                case 2:
-                case 3:
-                case 4: /* inline */
-                case 5: /* inline */
-                case 6: /* inline */
-                case 7: /* inline */
-                case 8: /* inline */
-                  i = i + 14;
-                  break;
-                case 9: /* inline */ /* tab */
-                  i = i + 14;
-                  g_string_append_unichar (substring, c);
-                  break;
-                case 10:
-                  break;
-                case 11:
-                case 12:
-                  i = i + 14;
-                  break;
-                case 13:
-                  break;
-                case 14:
-                case 15:
-                case 16:
-                case 17:
-                case 18:
-                case 19: /* inline */
-                case 20: /* inline */
-                case 21:
-                case 22:
-                case 23:
-                  i = i + 14;
-                  break;
-                case 24:
-                case 25:
-                case 26:
-                case 27:
-                case 28:
-                case 29:
-                case 30:
-                case 31:
-                  break;
-                default:
-                  /* HyPUA code */
-                  if (c >= 0xe0bc && c <= 0xf8f7)
-                  {
-                    const gunichar2 *unichar2;
-                    unichar2 = hyc2uni_page14[c-0xe0bc];
-                    for (int j = 0; j < 3; j++)
-                    {
-                      if (unichar2[j] == 0)
-                        break;
-
-                      g_string_append_unichar (substring, unichar2[j]);
-                    }
-                  }
-                  else
-                  {
-                    g_string_append_unichar (substring, c);
-                  }
-                  break;
-              } /* switch */
-            } /* for (guint i = pos1 * 2; i < pos2 * 2; i = i + 2) */
-
-            HwpTextAttributes *text_attrs = hwp_text_attributes_new ();
-            text_attrs->start_index = prev_index;
-            /* The character at end_index is not included */
-            text_attrs->end_index = text_attrs->start_index + strlen (substring->str);
-            g_ptr_array_add (paragraph->text_attrs, text_attrs);
+            /* 레코드 길이를 넘어서 읽지 않는다 */
+            pos2 = MIN (pos2, raw_text_len / 2);
+
+            if (raw_text && pos1 < pos2)
+              _hwp_para_text_append (string,
+                                     (const guint8 *) raw_text + pos1 * 2,
+                                     pos2 - pos1);
+
+            /* The byte at m_offset[j + 1] is not included */
+            paragraph->m_offset[j + 1] = string->len;
 #ifdef HWP_ENABLE_DEBUG
-            printf ("start:%d ~ end:%d:text:%s\n",
-                    text_attrs->start_index,
-                    text_attrs->end_index,
-                    substring->str);
+            printf ("start:%d ~ end:%d:text:%.*s\n",
+                    paragraph->m_offset[j],
+                    paragraph->m_offset[j + 1],
+                    (int) (paragraph->m_offset[j + 1] - paragraph->m_offset[j]),
+                    string->str + paragraph->m_offset[j]);
 #endif
-            prev_index = text_attrs->end_index;
-            g_string_append (string, g_string_free (substring, FALSE));
           } /* for (guint j = 0; j < paragraph->m_len; j++) */
           paragraph->text = g_string_free (string, FALSE);
         }
@@ -1488,17 +1565,35 @@ static HwpParagraph *hwp_hwp5_parser_build_paragraph (HwpHWP5Parser *parser,
 
   g_free (raw_text);
   raw_text = NULL;
+
+  if (!paragraph->text && (parser->flags & HWP_PARSE_FLAGS_TEXT_ONLY))
+    paragraph->text = g_strdup ("");
+
   return paragraph;
 }
 
+static void hwp_hwp5_parser_emit_paragraph (HwpHWP5Parser *parser,
+                                            HwpParagraph  *paragraph,
+                                            GError       **error)
+{
+  HwpListenableInterface *iface;
+  iface = HWP_LISTENABLE_GET_IFACE (parser->listenable);
+
+  if (iface->paragraph)
+    iface->paragraph (parser->listenable,
+                      paragraph,
+                      parser->user_data,
+                      error);
+  else
+    g_object_unref (paragraph);
+}
+
 static void hwp_hwp5_parser_parse_section (HwpHWP5Parser *parser,
                                            HwpHWP5File   *file,
                                            GError       **error)
 {
   g_return_if_fail (HWP_IS_HWP5_PARSER (parser) && HWP_IS_HWP5_FILE (file));
 
-  HwpListenableInterface *iface;
-  iface = HWP_LISTENABLE_GET_IFACE (parser->listenable);
   HwpParagraph *paragraph = NULL;
 
   while (hwp_hwp5_parser_pull (parser, error))
@@ -1515,14 +1610,12 @@ static void hwp_hwp5_parser_parse_section (HwpHWP5Parser *parser,
 
     if (paragraph)
     {
-      /* call callback function */
-      if (iface->paragraph)
-        iface->paragraph (parser->listenable,
-                          paragraph,
-                          parser->user_data,
-                          error);
+      paragraph->section_index = parser->section_index;
+
+      if (parser->paragraph_sink)
+        parser->paragraph_sink (paragraph, parser->sink_data, error);
       else
-        g_object_unref (paragraph);
+        hwp_hwp5_parser_emit_paragraph (parser, paragraph, error);
 
       paragraph = NULL;
     }
@@ -1535,15 +1628,517 @@ static void hwp_hwp5_parser_parse_sections (HwpHWP5Parser *parser,
 {
   g_return_if_fail (HWP_IS_HWP5_PARSER (parser) && HWP_IS_HWP5_FILE (file));
 
-  for (guint i = 0; i < file->section_streams->len; i++)
+  for (guint i = 0; i < hwp_hwp5_file_get_n_sections (file); i++)
   {
-    parser->stream = g_ptr_array_index (file->section_streams, i);
+    GInputStream *stream = hwp_hwp5_file_get_section_stream (file, i, error);
+
+    if (!stream)
+      break;
+
+    parser->section_index = i;
+    parser_set_stream (parser, stream);
     hwp_hwp5_parser_parse_section (parser, file, error);
     if (*error)
       break;
   }
 }
 
+typedef struct
+{
+  guint      index;
+  GPtrArray *paragraphs;
+  GError    *error;
+} JobResult;
+
+typedef struct
+{
+  HwpHWP5Parser *parser;
+  HwpHWP5File   *file;
+  GAsyncQueue   *results;
+  gint           cancelled;
+  /* section of the slices, for HWP_PARSE_FLAGS_PARALLEL_PARAGRAPHS */
+  guint          section_index;
+} ParseJobs;
+
+static JobResult *job_result_new (guint index)
+{
+  JobResult *result  = g_slice_new0 (JobResult);
+  result->index      = index;
+  result->paragraphs = g_ptr_array_new ();
+
+  return result;
+}
+
+static void job_result_free (JobResult *result)
+{
+  for (guint i = 0; i < result->paragraphs->len; i++)
+    if (g_ptr_array_index (result->paragraphs, i))
+      g_object_unref (g_ptr_array_index (result->paragraphs, i));
+
+  g_ptr_array_unref (result->paragraphs);
+  g_clear_error (&result->error);
+  g_slice_free (JobResult, result);
+}
+
+/* a parser for another thread, sharing the listener and the version of
+ * @parser, whose paragraphs go to @sink */
+static HwpHWP5Parser *worker_parser_new (HwpHWP5Parser *parser,
+                                         guint          section_index,
+                                         void         (*sink) (HwpParagraph *,
+                                                               gpointer,
+                                                               GError **),
+                                         gpointer       sink_data)
+{
+  HwpHWP5Parser *worker = hwp_hwp5_parser_new (parser->listenable,
+                                               parser->user_data);
+  worker->flags          = parser->flags;
+  worker->events         = parser->events;
+  worker->cancellable    = parser->cancellable;
+  worker->major_version  = parser->major_version;
+  worker->minor_version  = parser->minor_version;
+  worker->micro_version  = parser->micro_version;
+  worker->extra_version  = parser->extra_version;
+  worker->section_index  = section_index;
+  worker->paragraph_sink = sink;
+  worker->sink_data      = sink_data;
+
+  return worker;
+}
+
+static void collect_paragraph (HwpParagraph *paragraph,
+                               gpointer      paragraphs,
+                               GError      **error)
+{
+  g_ptr_array_add (paragraphs, paragraph);
+}
+
+/* runs on a pool thread; the index is pushed off by one since a
+ * GThreadPool can't take NULL */
+static void parse_section_job (gpointer data, gpointer user_data)
+{
+  ParseJobs    *jobs   = user_data;
+  JobResult    *result = job_result_new (GPOINTER_TO_UINT (data) - 1);
+  GInputStream *stream;
+
+  if (!g_atomic_int_get (&jobs->cancelled) &&
+      !g_cancellable_set_error_if_cancelled (jobs->parser->cancellable,
+                                             &result->error) &&
+      (stream = _hwp_hwp5_file_open_section (jobs->file, result->index,
+                                             TRUE, &result->error)))
+  {
+    HwpHWP5Parser *worker = worker_parser_new (jobs->parser, result->index,
+                                               collect_paragraph,
+                                               result->paragraphs);
+    parser_set_stream (worker, stream);
+    hwp_hwp5_parser_parse_section (worker, jobs->file, &result->error);
+
+    g_object_unref (worker);
+    g_object_unref (stream);
+  }
+
+  g_async_queue_push (jobs->results, result);
+}
+
+/* hands the paragraphs of @result to the listener on the calling thread */
+static void deliver_job_result (HwpHWP5Parser *parser,
+                                JobResult     *result,
+                                GError       **error)
+{
+  if (result->error)
+  {
+    g_propagate_error (error, result->error);
+    result->error = NULL;
+    return;
+  }
+
+  for (guint i = 0; i < result->paragraphs->len && !*error; i++)
+  {
+    HwpParagraph *paragraph = g_ptr_array_index (result->paragraphs, i);
+    g_ptr_array_index (result->paragraphs, i) = NULL;
+    hwp_hwp5_parser_emit_paragraph (parser, paragraph, error);
+  }
+}
+
+/* waits for @n_jobs results and delivers them, in job order unless
+ * @unordered; after an error the remaining jobs are cancelled and their
+ * results dropped */
+static void receive_job_results (HwpHWP5Parser *parser,
+                                 ParseJobs     *jobs,
+                                 guint          n_jobs,
+                                 gboolean       unordered,
+                                 GError       **error)
+{
+  JobResult **pending = g_new0 (JobResult *, n_jobs);
+  guint       next    = 0;
+
+  for (guint received = 0; received < n_jobs; received++)
+  {
+    JobResult *result = g_async_queue_pop (jobs->results);
+
+    if (*error)
+    {
+      job_result_free (result);
+      continue;
+    }
+
+    if (unordered)
+    {
+      deliver_job_result (parser, result, error);
+      job_result_free (result);
+    }
+    else
+    {
+      /* 앞의 작업이 모두 끝날 때까지 보관한다 */
+      pending[result->index] = result;
+
+      while (next < n_jobs && pending[next] && !*error)
+      {
+        deliver_job_result (parser, pending[next], error);
+        job_result_free (pending[next]);
+        pending[next++] = NULL;
+      }
+    }
+
+    if (*error)
+      g_atomic_int_set (&jobs->cancelled, 1);
+  }
+
+  for (guint i = 0; i < n_jobs; i++)
+    if (pending[i])
+      job_result_free (pending[i]);
+
+  g_free (pending);
+}
+
+static void hwp_hwp5_parser_parse_sections_parallel (HwpHWP5Parser *parser,
+                                                     HwpHWP5File   *file,
+                                                     GError       **error)
+{
+  guint        n_sections = hwp_hwp5_file_get_n_sections (file);
+  ParseJobs    jobs       = { parser, file, NULL, 0, 0 };
+  GThreadPool *pool;
+
+  if (n_sections == 0)
+    return;
+
+  jobs.results = g_async_queue_new ();
+  pool = g_thread_pool_new (parse_section_job, &jobs,
+                            MIN (g_get_num_processors (), n_sections),
+                            FALSE, error);
+  if (!pool)
+  {
+    g_async_queue_unref (jobs.results);
+    return;
+  }
+
+  for (guint i = 0; i < n_sections; i++)
+    g_thread_pool_push (pool, GUINT_TO_POINTER (i + 1), NULL);
+
+  receive_job_results (parser, &jobs, n_sections,
+                       parser->flags & HWP_PARSE_FLAGS_UNORDERED, error);
+
+  g_thread_pool_free (pool, FALSE, TRUE);
+  g_async_queue_unref (jobs.results);
+}
+
+/* a run of top level paragraphs of an inflated section */
+typedef struct
+{
+  guint   index;
+  GBytes *bytes;
+} SectionSlice;
+
+static void parse_slice_job (gpointer data, gpointer user_data)
+{
+  ParseJobs    *jobs   = user_data;
+  SectionSlice *slice  = data;
+  JobResult    *result = job_result_new (slice->index);
+
+  if (!g_atomic_int_get (&jobs->cancelled))
+  {
+    GInputStream  *stream = g_memory_input_stream_new_from_bytes (slice->bytes);
+    HwpHWP5Parser *worker = worker_parser_new (jobs->parser,
+                                               jobs->section_index,
+                                               collect_paragraph,
+                                               result->paragraphs);
+    parser_set_stream (worker, stream);
+    hwp_hwp5_parser_parse_section (worker, jobs->file, &result->error);
+
+    g_object_unref (worker);
+    g_object_unref (stream);
+  }
+
+  g_bytes_unref (slice->bytes);
+  g_slice_free (SectionSlice, slice);
+  g_async_queue_push (jobs->results, result);
+}
+
+/*
+ * Walks the record headers of an inflated section without decoding any
+ * payload and returns the offsets of its level 0 PARA_HEADER records,
+ * i.e. where independent paragraph subtrees start.  Scanning stops at a
+ * truncated record; the parser reports it when it gets there.
+ */
+static GArray *scan_paragraph_offsets (const guint8 *data, gsize len)
+{
+  GArray *offsets = g_array_new (FALSE, FALSE, sizeof (gsize));
+  gsize   pos     = 0;
+
+  while (pos + 4 <= len)
+  {
+    gsize   start  = pos;
+    guint32 header = GSF_LE_GET_GUINT32 (data + pos);
+    guint16 tag_id = (guint16) ( header        & 0x3ff);
+    guint16 level  = (guint16) ((header >> 10) & 0x3ff);
+    guint32 size   = (guint32) ((header >> 20) & 0xfff);
+
+    pos += 4;
+
+    if (size == 0xfff)
+    {
+      if (pos + 4 > len)
+        break;
+
+      size = GSF_LE_GET_GUINT32 (data + pos);
+      pos += 4;
+    }
+
+    if (tag_id == HWP_TAG_PARA_HEADER && level == 0)
+      g_array_append_val (offsets, start);
+
+    if (size > len - pos)
+      break;
+
+    pos += size;
+  }
+
+  return offsets;
+}
+
+static void hwp_hwp5_parser_parse_paragraphs_parallel (HwpHWP5Parser *parser,
+                                                       HwpHWP5File   *file,
+                                                       GError       **error)
+{
+  guint        n_sections = hwp_hwp5_file_get_n_sections (file);
+  guint        n_threads  = g_get_num_processors ();
+  ParseJobs    jobs       = { parser, file, NULL, 0, 0 };
+  GThreadPool *pool;
+
+  if (n_sections == 0)
+    return;
+
+  jobs.results = g_async_queue_new ();
+  pool = g_thread_pool_new (parse_slice_job, &jobs, n_threads, FALSE, error);
+  if (!pool)
+  {
+    g_async_queue_unref (jobs.results);
+    return;
+  }
+
+  for (guint i = 0; i < n_sections && !*error; i++)
+  {
+    GBytes       *bytes;
+    const guint8 *data;
+    gsize         len;
+    GArray       *offsets;
+    gsize         slice_len;
+    gsize         start   = 0;
+    guint         n_jobs  = 0;
+
+    if (g_cancellable_set_error_if_cancelled (parser->cancellable, error))
+      break;
+
+    bytes = _hwp_hwp5_file_read_section (file, i, error);
+
+    if (!bytes)
+      break;
+
+    data    = g_bytes_get_data (bytes, &len);
+    offsets = scan_paragraph_offsets (data, len);
+
+    /* a few slices per thread so that uneven paragraphs even out;
+     * slices are cut only at top level paragraph boundaries */
+    slice_len = MAX (len / (n_threads * 4), 1);
+
+    jobs.section_index = i;
+
+    for (guint j = 0; j <= offsets->len; j++)
+    {
+      gsize end = j < offsets->len ? g_array_index (offsets, gsize, j) : len;
+
+      if (end <= start || (end - start < slice_len && j < offsets->len))
+        continue;
+
+      SectionSlice *slice = g_slice_new (SectionSlice);
+      slice->index = n_jobs++;
+      slice->bytes = g_bytes_new_from_bytes (bytes, start, end - start);
+      g_thread_pool_push (pool, slice, NULL);
+      start = end;
+    }
+
+    receive_job_results (parser, &jobs, n_jobs, FALSE, error);
+
+    g_array_unref (offsets);
+    g_bytes_unref (bytes);
+  }
+
+  g_thread_pool_free (pool, FALSE, TRUE);
+  g_async_queue_unref (jobs.results);
+}
+
+#define PIPELINE_CHUNK_SIZE          (64 * 1024)
+#define PIPELINE_CHUNK_QUEUE_LEN     8
+#define PIPELINE_PARAGRAPH_QUEUE_LEN 256
+
+typedef struct
+{
+  HwpHWP5Parser   *parser;
+  HwpHWP5File     *file;
+  HwpBoundedQueue *chunks;     /* inflate -> decode, GBytes */
+  HwpBoundedQueue *paragraphs; /* decode -> listener, HwpParagraph */
+  GError          *inflate_error;
+  GError          *decode_error;
+} Pipeline;
+
+/* stage 1: inflates the sections ahead of the decoder; an empty chunk
+ * ends each section */
+static gpointer pipeline_inflate (gpointer data)
+{
+  Pipeline *pipeline   = data;
+  guint     n_sections = hwp_hwp5_file_get_n_sections (pipeline->file);
+
+  for (guint i = 0; i < n_sections; i++)
+  {
+    GInputStream *stream;
+    gboolean      ok = TRUE;
+
+    stream = _hwp_hwp5_file_open_section (pipeline->file, i, TRUE,
+                                          &pipeline->inflate_error);
+    if (!stream)
+      break;
+
+    while (ok)
+    {
+      guint8 *buffer = g_malloc (PIPELINE_CHUNK_SIZE);
+      gssize  len    = g_input_stream_read (stream, buffer,
+                                            PIPELINE_CHUNK_SIZE,
+                                            pipeline->parser->cancellable,
+                                            &pipeline->inflate_error);
+      if (len <= 0)
+      {
+        g_free (buffer);
+        ok = (len == 0);
+        break;
+      }
+
+      ok = _hwp_bounded_queue_push (pipeline->chunks,
+                                    g_bytes_new_take (buffer, len));
+    }
+
+    g_object_unref (stream);
+
+    if (!ok ||
+        !_hwp_bounded_queue_push (pipeline->chunks, g_bytes_new (NULL, 0)))
+      break;
+  }
+
+  _hwp_bounded_queue_close (pipeline->chunks);
+
+  return NULL;
+}
+
+static void queue_paragraph (HwpParagraph *paragraph,
+                             gpointer      queue,
+                             GError      **error)
+{
+  /* fails only if the listener stage gave up */
+  if (!_hwp_bounded_queue_push (queue, paragraph) && !*error)
+    g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_CANCELLED,
+                         "parse cancelled");
+}
+
+/* stage 2: decodes records into paragraphs */
+static gpointer pipeline_decode (gpointer data)
+{
+  Pipeline      *pipeline   = data;
+  guint          n_sections = hwp_hwp5_file_get_n_sections (pipeline->file);
+  GInputStream  *stream     = _hwp_queue_input_stream_new (pipeline->chunks);
+  HwpHWP5Parser *worker;
+
+  worker = worker_parser_new (pipeline->parser, 0,
+                              queue_paragraph, pipeline->paragraphs);
+
+  for (guint i = 0; i < n_sections && !pipeline->decode_error; i++)
+  {
+    worker->section_index = i;
+    _hwp_queue_input_stream_next (HWP_QUEUE_INPUT_STREAM (stream));
+    parser_set_stream (worker, stream);
+    hwp_hwp5_parser_parse_section (worker, pipeline->file,
+                                   &pipeline->decode_error);
+  }
+
+  /* after a decode error the inflater may be blocked on a full queue */
+  _hwp_bounded_queue_cancel (pipeline->chunks);
+  _hwp_bounded_queue_close (pipeline->paragraphs);
+  g_object_unref (worker);
+  g_object_unref (stream);
+
+  return NULL;
+}
+
+/* stage 3 runs on the calling thread and invokes the listener */
+static void hwp_hwp5_parser_parse_sections_pipelined (HwpHWP5Parser *parser,
+                                                      HwpHWP5File   *file,
+                                                      GError       **error)
+{
+  Pipeline      pipeline = { parser, file, NULL, NULL, NULL, NULL };
+  GThread      *inflater;
+  GThread      *decoder;
+  HwpParagraph *paragraph;
+
+  pipeline.chunks     = _hwp_bounded_queue_new (PIPELINE_CHUNK_QUEUE_LEN,
+                                                (GDestroyNotify) g_bytes_unref);
+  pipeline.paragraphs = _hwp_bounded_queue_new (PIPELINE_PARAGRAPH_QUEUE_LEN,
+                                                g_object_unref);
+
+  inflater = g_thread_new ("hwp-inflate", pipeline_inflate, &pipeline);
+  decoder  = g_thread_new ("hwp-decode",  pipeline_decode,  &pipeline);
+
+  while ((paragraph = _hwp_bounded_queue_pop (pipeline.paragraphs)))
+  {
+    hwp_hwp5_parser_emit_paragraph (parser, paragraph, error);
+
+    if (*error)
+    {
+      /* unblock both producers */
+      _hwp_bounded_queue_cancel (pipeline.paragraphs);
+      _hwp_bounded_queue_cancel (pipeline.chunks);
+      break;
+    }
+  }
+
+  g_thread_join (inflater);
+  g_thread_join (decoder);
+
+  /* the decoder fails as a consequence of an inflate error; report the
+   * cause */
+  if (!*error && pipeline.inflate_error)
+  {
+    g_propagate_error (error, pipeline.inflate_error);
+    pipeline.inflate_error = NULL;
+  }
+  else if (!*error && pipeline.decode_error)
+  {
+    g_propagate_error (error, pipeline.decode_error);
+    pipeline.decode_error = NULL;
+  }
+
+  g_clear_error (&pipeline.inflate_error);
+  g_clear_error (&pipeline.decode_error);
+  _hwp_bounded_queue_free (pipeline.chunks);
+  _hwp_bounded_queue_free (pipeline.paragraphs);
+}
+
 /* 알려지지 않은 것을 감지하기 위해 이렇게 작성함 */
 static void metadata_hash_func (gpointer k, gpointer v, gpointer user_data)
 {
@@ -1774,6 +2369,8 @@ void hwp_hwp5_parser_parse (HwpHWP5Parser *parser,
 {
   g_return_if_fail (HWP_IS_HWP5_PARSER (parser) && HWP_IS_HWP5_FILE (file));
 
+  parser->events = hwp_listenable_get_event_mask (parser->listenable);
+
   hwp_hwp5_parser_parse_file_header    (parser, file, error);
 
   if (*error) {
@@ -1781,21 +2378,38 @@ void hwp_hwp5_parser_parse (HwpHWP5Parser *parser,
     return;
   }
 
-  hwp_hwp5_parser_parse_doc_info       (parser, file, error);
+  /* DocInfo 와 본문은 메타데이터만 읽을 때 건너뛴다 */
+  if (!(parser->flags & HWP_PARSE_FLAGS_METADATA_ONLY)) {
+    /* 텍스트만 읽을 때는 서식 정보인 DocInfo 가 필요 없다 */
+    if (!(parser->flags & HWP_PARSE_FLAGS_TEXT_ONLY) &&
+        (parser->events & HWP_EVENT_DOC_INFO))
+      hwp_hwp5_parser_parse_doc_info     (parser, file, error);
 
-  if (*error) {
-    g_warning ("%s:%d:%s\n", __FILE__, __LINE__, (*error)->message);
-    return;
-  }
+    if (*error) {
+      g_warning ("%s:%d:%s\n", __FILE__, __LINE__, (*error)->message);
+      return;
+    }
 
-  hwp_hwp5_parser_parse_sections       (parser, file, error);
+    /* 문단을 받지 않으면 본문 스트림은 열지도 않는다 */
+    if (parser->events & HWP_EVENT_PARAGRAPHS) {
+      if (parser->flags & HWP_PARSE_FLAGS_PARALLEL_SECTIONS)
+        hwp_hwp5_parser_parse_sections_parallel (parser, file, error);
+      else if (parser->flags & HWP_PARSE_FLAGS_PARALLEL_PARAGRAPHS)
+        hwp_hwp5_parser_parse_paragraphs_parallel (parser, file, error);
+      else if (parser->flags & HWP_PARSE_FLAGS_PIPELINE)
+        hwp_hwp5_parser_parse_sections_pipelined (parser, file, error);
+      else
+        hwp_hwp5_parser_parse_sections       (parser, file, error);
+    }
 
-  if (*error) {
-    g_warning ("%s:%d:%s\n", __FILE__, __LINE__, (*error)->message);
-    return;
+    if (*error) {
+      g_warning ("%s:%d:%s\n", __FILE__, __LINE__, (*error)->message);
+      return;
+    }
   }
 
-  hwp_hwp5_parser_parse_summary_info   (parser, file, error);
+  if (parser->events & HWP_EVENT_SUMMARY_INFO)
+    hwp_hwp5_parser_parse_summary_info (parser, file, error);
 /*  _hwp_hwp5_parser_parse_bin_data       (parser, file, error); */
 
   if (*error) {
@@ -1803,7 +2417,8 @@ void hwp_hwp5_parser_parse (HwpHWP5Parser *parser,
     return;
   }
 
-  hwp_hwp5_parser_parse_prv_text       (parser, file, error);
+  if (parser->events & HWP_EVENT_PRV_TEXT)
+    hwp_hwp5_parser_parse_prv_text     (parser, file, error);
 
   if (*error) {
     g_warning ("%s:%d:%s\n", __FILE__, __LINE__, (*error)->message);
@@ -1818,11 +2433,16 @@ void hwp_hwp5_parser_parse (HwpHWP5Parser *parser,
 
 static void hwp_hwp5_parser_init (HwpHWP5Parser *parser)
 {
-  parser->state = HWP_PARSE_STATE_NORMAL;
+  parser->state       = HWP_PARSE_STATE_NORMAL;
+  parser->data_loaded = TRUE;
+  parser->events      = HWP_EVENT_ALL;
 }
 
 static void hwp_hwp5_parser_finalize (GObject *object)
 {
+  HwpHWP5Parser *parser = HWP_HWP5_PARSER (object);
+  g_free (parser->data);
+
   G_OBJECT_CLASS (hwp_hwp5_parser_parent_class)->finalize (object);
 }
 
@@ -45,6 +45,7 @@
 #include <glib-object.h>
 #include <gio/gio.h>
 
+#include "hwp-enums.h"
 #include "hwp-hwp5-file.h"
 #include "hwp-listenable.h"
 
@@ -66,6 +67,11 @@ struct _HwpHWP5Parser
 
   HwpListenable *listenable;
   gpointer       user_data;
+  HwpParseFlags  flags;
+  /* events the listener consumes */
+  HwpEventMask   events;
+  /* checked between records; not referenced */
+  GCancellable  *cancellable;
   GInputStream  *stream;
   /* from record header */
   guint32        header;
@@ -74,6 +80,10 @@ struct _HwpHWP5Parser
   guint32        data_len;
   /* for sanity checking */
   guint32        data_pos;
+  /* record payload, reused from record to record */
+  guint8        *data;
+  gsize          data_capacity;
+  gboolean       data_loaded;
   /* for parsing */
   guint8         state;
   guint32        ctrl_id;
@@ -82,6 +92,13 @@ struct _HwpHWP5Parser
   guint8         minor_version;
   guint8         micro_version;
   guint8         extra_version;
+  /* section being parsed */
+  guint          section_index;
+  /* if set, paragraphs go here instead of to the listener */
+  void         (*paragraph_sink) (HwpParagraph *paragraph,
+                                  gpointer      sink_data,
+                                  GError      **error);
+  gpointer       sink_data;
 };
 
 /**
@@ -37,12 +37,53 @@
 
 #include <string.h>
 #include <math.h>
+#include <gsf/gsf-input-gio.h>
+#include <gsf/gsf-input-gzip.h>
+#include <gsf/gsf-input-stdio.h>
+#include "hwp-file-private.h"
 #include "hwp-hwpml-file.h"
 #include "hwp-hwpml-parser.h"
 #include "hwp-enums.h"
 
 G_DEFINE_TYPE (HwpHWPMLFile, hwp_hwpml_file, HWP_TYPE_FILE);
 
+HwpHWPMLFile *_hwp_hwpml_file_new_for_gsf_input (GsfInput *input,
+                                                GError  **error)
+{
+  guint8        magic[2];
+  gboolean      is_gzip;
+  HwpHWPMLFile *file;
+
+  is_gzip = gsf_input_size (input) >= 2 &&
+            gsf_input_read (input, 2, magic) &&
+            _hwp_is_gzip (magic, 2);
+
+  if (gsf_input_seek (input, 0, G_SEEK_SET))
+  {
+    g_set_error (error, HWP_FILE_ERROR, HWP_FILE_ERROR_FAILED,
+                        "failed to read %s", gsf_input_name (input));
+    return NULL;
+  }
+
+  /* .hml.gz 는 임시 파일 없이 풀면서 읽는다 */
+  if (is_gzip)
+  {
+    input = gsf_input_gzip_new (input, error);
+
+    if (!input)
+      return NULL;
+  }
+  else
+  {
+    g_object_ref (input);
+  }
+
+  file = g_object_new (HWP_TYPE_HWPML_FILE, NULL);
+  file->priv->input = input;
+
+  return file;
+}
+
 /**
  * hwp_hwpml_file_new_for_path:
  * @path: path of the file to load
@@ -60,10 +101,13 @@ HwpHWPMLFile *hwp_hwpml_file_new_for_path (const gchar *path, GError **error)
 {
   g_return_val_if_fail (path != NULL, NULL);
 
-  HwpHWPMLFile *file = g_object_new (HWP_TYPE_HWPML_FILE, NULL);
-  GFile *gfile = g_file_new_for_path (path);
-  file->priv->uri = g_file_get_uri (gfile);
-  g_object_unref (gfile);
+  GsfInput *input = gsf_input_stdio_new (path, error);
+
+  if (!input)
+    return NULL;
+
+  HwpHWPMLFile *file = _hwp_hwpml_file_new_for_gsf_input (input, error);
+  g_object_unref (input);
 
   return file;
 }
@@ -85,8 +129,100 @@ HwpHWPMLFile *hwp_hwpml_file_new_for_uri (const gchar *uri, GError **error)
 {
   g_return_val_if_fail (uri != NULL, NULL);
 
+  GsfInput *input = gsf_input_gio_new_for_uri (uri, error);
+
+  if (!input)
+    return NULL;
+
+  HwpHWPMLFile *file = _hwp_hwpml_file_new_for_gsf_input (input, error);
+  g_object_unref (input);
+
+  return file;
+}
+
+/**
+ * hwp_hwpml_file_new_for_bytes:
+ * @bytes: a #GBytes containing the whole document
+ * @error: location to store the error occurring, or %NULL to ignore
+ *
+ * Creates a new #HwpHWPMLFile which parses the document directly from
+ * @bytes, without copying it. A gzip compressed document is inflated
+ * while it is parsed. If %NULL is returned, then @error will be
+ * set. Possible errors include those in the #HWP_ERROR and #HWP_FILE_ERROR
+ * domains.
+ *
+ * Return value: A newly created #HwpHWPMLFile, or %NULL
+ *
+ * Since: 2016.06.01
+ */
+HwpHWPMLFile *hwp_hwpml_file_new_for_bytes (GBytes *bytes, GError **error)
+{
+  g_return_val_if_fail (bytes != NULL, NULL);
+
+  gsize         size;
+  const guint8 *data = g_bytes_get_data (bytes, &size);
   HwpHWPMLFile *file = g_object_new (HWP_TYPE_HWPML_FILE, NULL);
-  file->priv->uri = g_strdup (uri);
+  file->priv->bytes   = g_bytes_ref (bytes);
+  file->priv->is_gzip = _hwp_is_gzip (data, size);
+
+  return file;
+}
+
+/**
+ * hwp_hwpml_file_new_for_stream:
+ * @stream: a #GInputStream positioned at the start of the document
+ * @error: location to store the error occurring, or %NULL to ignore
+ *
+ * Creates a new #HwpHWPMLFile which parses the document from @stream as
+ * it is read, so it may be a pipe or a socket. A gzip compressed document
+ * is inflated on the fly. The stream is consumed by the first parse.
+ * If %NULL is returned, then @error will be set. Possible errors include
+ * those in the #G_IO_ERROR, #HWP_ERROR and #HWP_FILE_ERROR domains.
+ *
+ * Return value: A newly created #HwpHWPMLFile, or %NULL
+ *
+ * Since: 2016.06.01
+ */
+HwpHWPMLFile *hwp_hwpml_file_new_for_stream (GInputStream *stream,
+                                             GError      **error)
+{
+  g_return_val_if_fail (G_IS_INPUT_STREAM (stream), NULL);
+
+  GInputStream *buffered;
+  const guint8 *data;
+  gsize         len;
+  HwpHWPMLFile *file;
+
+  /* 앞부분은 버퍼에 남아 있다가 파서가 그대로 읽는다 */
+  if (G_IS_BUFFERED_INPUT_STREAM (stream))
+    buffered = g_object_ref (stream);
+  else
+    buffered = g_buffered_input_stream_new (stream);
+
+  data = _hwp_input_stream_peek (G_BUFFERED_INPUT_STREAM (buffered), 2,
+                                 &len, error);
+  if (!data)
+  {
+    g_object_unref (buffered);
+    return NULL;
+  }
+
+  file = g_object_new (HWP_TYPE_HWPML_FILE, NULL);
+
+  if (_hwp_is_gzip (data, len))
+  {
+    GZlibDecompressor *zd;
+
+    zd = g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP);
+    file->priv->stream = g_converter_input_stream_new (buffered,
+                                                       G_CONVERTER (zd));
+    g_object_unref (zd);
+    g_object_unref (buffered);
+  }
+  else
+  {
+    file->priv->stream = buffered;
+  }
 
   return file;
 }
@@ -131,7 +267,14 @@ static void hwp_hwpml_file_finalize (GObject *object)
 {
   HwpHWPMLFile *file = HWP_HWPML_FILE(object);
 
-  g_free (file->priv->uri);
+  if (file->priv->bytes)
+    g_bytes_unref (file->priv->bytes);
+
+  if (file->priv->input)
+    g_object_unref (file->priv->input);
+
+  if (file->priv->stream)
+    g_object_unref (file->priv->stream);
 
   G_OBJECT_CLASS (hwp_hwpml_file_parent_class)->finalize (object);
 }
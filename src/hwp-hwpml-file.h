@@ -43,6 +43,7 @@
 #define __HWP_HWPML_FILE_H__
 
 #include <glib-object.h>
+#include <gsf/gsf-input.h>
 
 #include "hwp-file.h"
 #include "hwp-models.h"
@@ -79,7 +80,10 @@ struct _HwpHWPMLFileClass
 
 struct _HwpHWPMLFilePrivate
 {
-  gchar *uri;
+  GBytes       *bytes;
+  gboolean      is_gzip; /* bytes hold a gzip member */
+  GsfInput     *input;
+  GInputStream *stream;
 };
 
 GType         hwp_hwpml_file_get_type               (void) G_GNUC_CONST;
@@ -87,6 +91,10 @@ HwpHWPMLFile *hwp_hwpml_file_new_for_path           (const gchar *path,
                                                      GError     **error);
 HwpHWPMLFile *hwp_hwpml_file_new_for_uri            (const gchar *uri,
                                                      GError     **error);
+HwpHWPMLFile *hwp_hwpml_file_new_for_bytes          (GBytes      *bytes,
+                                                     GError     **error);
+HwpHWPMLFile *hwp_hwpml_file_new_for_stream         (GInputStream *stream,
+                                                     GError      **error);
 gchar        *hwp_hwpml_file_get_hwp_version_string (HwpFile     *file);
 void          hwp_hwpml_file_get_hwp_version        (HwpFile     *file,
                                                      guint8      *major_version,
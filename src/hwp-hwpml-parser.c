@@ -36,12 +36,408 @@
  */
 
 #include "hwp-hwpml-parser.h"
-#include <libxml/xmlreader.h>
+#include <libxml/parser.h>
 #include "hwp-enums.h"
+#include "hwp-sax-body.h"
 #include <string.h>
 
 G_DEFINE_TYPE (HwpHWPMLParser, hwp_hwpml_parser, G_TYPE_OBJECT)
 
+/*
+ * HWPML is parsed with the SAX2 interface of libxml2: no tree is built
+ * and elements are handled as they stream past, so memory stays bounded
+ * by the nesting of the document, not by its size.  Paragraphs, tables
+ * and section definitions are delivered with the same models and
+ * HwpListenable callbacks as the HWP 5.0 parser.
+ */
+
+typedef enum {
+  HWPML_TAG_OTHER,
+  HWPML_TAG_DOCSUMMARY,
+  HWPML_TAG_TITLE,
+  HWPML_TAG_SUBJECT,
+  HWPML_TAG_AUTHOR,
+  HWPML_TAG_KEYWORDS,
+  HWPML_TAG_COMMENTS,
+  HWPML_TAG_BODY,
+  HWPML_TAG_P,
+  HWPML_TAG_TEXT,
+  HWPML_TAG_CHAR,
+  HWPML_TAG_TAB,
+  HWPML_TAG_LINEBREAK,
+  HWPML_TAG_SECDEF,
+  HWPML_TAG_PAGEDEF,
+  HWPML_TAG_PAGEMARGIN,
+  HWPML_TAG_TABLE,
+  HWPML_TAG_INSIDEMARGIN,
+  HWPML_TAG_CELL,
+  HWPML_TAG_CELLMARGIN,
+  HWPML_TAG_N
+} HwpmlTag;
+
+static const gchar * const hwpml_tag_names[HWPML_TAG_N] =
+{
+  NULL,
+  "DOCSUMMARY",
+  "TITLE",
+  "SUBJECT",
+  "AUTHOR",
+  "KEYWORDS",
+  "COMMENTS",
+  "BODY",
+  "P",
+  "TEXT",
+  "CHAR",
+  "TAB",
+  "LINEBREAK",
+  "SECDEF",
+  "PAGEDEF",
+  "PAGEMARGIN",
+  "TABLE",
+  "INSIDEMARGIN",
+  "CELL",
+  "CELLMARGIN"
+};
+
+typedef struct {
+  HwpHWPMLParser         *parser;
+  HwpListenableInterface *iface;
+  xmlParserCtxtPtr        ctxt;
+  GError                **error;  /* never NULL */
+  GInputStream           *stream; /* read by read_input_stream () */
+
+  GHashTable             *tags;   /* interned name -> HwpmlTag */
+  HwpSaxBody              body;
+
+  gboolean                in_summary;
+  gchar                 **field;  /* summary field being read */
+  HwpEventMask            events;
+  GString                *buffer;
+  gboolean                stopped;
+} HwpmlContext;
+
+static HwpmlTag hwpml_tag_lookup (HwpmlContext *context, const xmlChar *name)
+{
+  gpointer value;
+  guint    i;
+
+  /* libxml2 interns element names in the dictionary of the parser, so
+   * each distinct name is matched once and then found by pointer */
+  if (g_hash_table_lookup_extended (context->tags, name, NULL, &value))
+    return GPOINTER_TO_UINT (value);
+
+  /* 태그 이름은 대소문자를 구분하지 않는다; ASCII 로 충분하다 */
+  for (i = 1; i < HWPML_TAG_N; i++)
+    if (g_ascii_strcasecmp ((const gchar *) name, hwpml_tag_names[i]) == 0)
+      break;
+
+  if (i == HWPML_TAG_N)
+    i = HWPML_TAG_OTHER;
+
+  g_hash_table_insert (context->tags, (gpointer) name, GUINT_TO_POINTER (i));
+
+  return i;
+}
+
+static guint32 hwpml_attr_uint (int             n_attributes,
+                                const xmlChar **attributes,
+                                const gchar    *name)
+{
+  return _hwp_sax_attr_uint (n_attributes, attributes, name, TRUE);
+}
+
+/* for the guint16 fields of the models; saturated rather than truncated */
+static guint16 hwpml_attr_uint16 (int             n_attributes,
+                                  const xmlChar **attributes,
+                                  const gchar    *name)
+{
+  return _hwp_sax_attr_uint16 (n_attributes, attributes, name, TRUE);
+}
+
+static void hwpml_emit_paragraph (HwpmlContext *context,
+                                  HwpParagraph *paragraph)
+{
+  if (context->iface->paragraph)
+    context->iface->paragraph (context->parser->listenable,
+                               paragraph,
+                               context->parser->user_data,
+                               context->error);
+  else
+    g_object_unref (paragraph);
+}
+
+static void hwpml_end_paragraph (HwpmlContext *context)
+{
+  HwpParagraph *paragraph = _hwp_sax_end_paragraph (&context->body, 0);
+
+  if (paragraph)
+    hwpml_emit_paragraph (context, paragraph);
+}
+
+static void hwpml_begin_table (HwpmlContext    *context,
+                               int              n_attributes,
+                               const xmlChar  **attributes)
+{
+  HwpSaxTable *t;
+
+  t = _hwp_sax_begin_table (&context->body,
+                            hwpml_attr_uint16 (n_attributes, attributes, "RowCount"),
+                            hwpml_attr_uint16 (n_attributes, attributes, "ColCount"));
+
+  t->table->cell_spacing   = hwpml_attr_uint16 (n_attributes, attributes, "CellSpacing");
+  t->table->border_fill_id = hwpml_attr_uint16 (n_attributes, attributes, "BorderFill");
+}
+
+static void hwpml_begin_cell (HwpmlContext    *context,
+                              int              n_attributes,
+                              const xmlChar  **attributes)
+{
+  HwpSaxTable  *t = _hwp_sax_top_table (&context->body);
+  HwpTableCell *cell;
+
+  if (!t || t->cell)
+    return;
+
+  cell = hwp_table_cell_new ();
+  cell->col_addr       = hwpml_attr_uint16 (n_attributes, attributes, "ColAddr");
+  cell->row_addr       = hwpml_attr_uint16 (n_attributes, attributes, "RowAddr");
+  cell->col_span       = hwpml_attr_uint16 (n_attributes, attributes, "ColSpan");
+  cell->row_span       = hwpml_attr_uint16 (n_attributes, attributes, "RowSpan");
+  cell->width          = hwpml_attr_uint (n_attributes, attributes, "Width");
+  cell->height         = hwpml_attr_uint (n_attributes, attributes, "Height");
+  cell->border_fill_id = hwpml_attr_uint16 (n_attributes, attributes, "BorderFill");
+
+  t->cell = cell;
+}
+
+static void hwpml_start_element (void           *user_data,
+                                 const xmlChar  *localname,
+                                 const xmlChar  *prefix,
+                                 const xmlChar  *uri,
+                                 int             n_namespaces,
+                                 const xmlChar **namespaces,
+                                 int             n_attributes,
+                                 int             n_defaulted,
+                                 const xmlChar **attributes)
+{
+  HwpmlContext *context = user_data;
+  HwpSaxPara   *para    = _hwp_sax_top_para (&context->body);
+  HwpSaxTable  *table   = _hwp_sax_top_table (&context->body);
+  HwpHWPMLParserPrivate *priv = context->parser->priv;
+  gboolean      layout  = !(context->parser->flags & HWP_PARSE_FLAGS_TEXT_ONLY);
+
+  /* 요소 사이에서 취소를 확인한다; 오류 뒤에는 더 읽지 않는다 */
+  if (*context->error ||
+      g_cancellable_set_error_if_cancelled (context->parser->cancellable,
+                                            context->error))
+  {
+    context->stopped = TRUE;
+    xmlStopParser (context->ctxt);
+    return;
+  }
+
+  switch (hwpml_tag_lookup (context, localname))
+  {
+    case HWPML_TAG_DOCSUMMARY:
+      g_clear_object (&priv->info);
+      priv->info = hwp_summary_info_new ();
+      context->in_summary = TRUE;
+      break;
+    case HWPML_TAG_TITLE:
+      if (context->in_summary) context->field = &priv->info->title;
+      break;
+    case HWPML_TAG_SUBJECT:
+      if (context->in_summary) context->field = &priv->info->subject;
+      break;
+    case HWPML_TAG_AUTHOR:
+      if (context->in_summary) context->field = &priv->info->creator;
+      break;
+    case HWPML_TAG_KEYWORDS:
+      if (context->in_summary) context->field = &priv->info->keywords;
+      break;
+    case HWPML_TAG_COMMENTS:
+      if (context->in_summary) context->field = &priv->info->desc;
+      break;
+    case HWPML_TAG_BODY:
+      /* HEAD 의 DOCSUMMARY 는 BODY 앞에 있다 */
+      if ((context->parser->flags & HWP_PARSE_FLAGS_METADATA_ONLY) ||
+          !(context->events & HWP_EVENT_PARAGRAPHS))
+      {
+        context->stopped = TRUE;
+        xmlStopParser (context->ctxt);
+      }
+      break;
+    case HWPML_TAG_P:
+      _hwp_sax_begin_paragraph (&context->body, layout);
+      break;
+    case HWPML_TAG_TEXT:
+      /* <TEXT> 하나가 글자 모양 구간 하나이다 */
+      if (para)
+        _hwp_sax_add_run (para, hwpml_attr_uint (n_attributes, attributes, "CharShape"));
+      break;
+    case HWPML_TAG_CHAR:
+      if (para)
+        para->in_text++;
+      break;
+    case HWPML_TAG_TAB:
+      if (para)
+        g_string_append_c (para->text, '\t');
+      break;
+    case HWPML_TAG_LINEBREAK:
+      if (para)
+        g_string_append_c (para->text, '\n');
+      break;
+    case HWPML_TAG_SECDEF:
+      if (layout && para && !para->paragraph->secd)
+        hwp_paragraph_set_secd (para->paragraph, hwp_secd_new ());
+      break;
+    case HWPML_TAG_PAGEDEF:
+      if (para && para->paragraph->secd)
+      {
+        HwpSecd *secd = para->paragraph->secd;
+        secd->page_width_in_points  = hwpml_attr_uint (n_attributes, attributes, "Width") / 7200.0 * 72;
+        secd->page_height_in_points = hwpml_attr_uint (n_attributes, attributes, "Height") / 7200.0 * 72;
+      }
+      break;
+    case HWPML_TAG_PAGEMARGIN:
+      if (para && para->paragraph->secd)
+      {
+        HwpSecd *secd = para->paragraph->secd;
+        secd->page_left_margin_in_points   = hwpml_attr_uint (n_attributes, attributes, "Left") / 7200.0 * 72;
+        secd->page_right_margin_in_points  = hwpml_attr_uint (n_attributes, attributes, "Right") / 7200.0 * 72;
+        secd->page_top_margin_in_points    = hwpml_attr_uint (n_attributes, attributes, "Top") / 7200.0 * 72;
+        secd->page_bottom_margin_in_points = hwpml_attr_uint (n_attributes, attributes, "Bottom") / 7200.0 * 72;
+        secd->page_header_margin_in_points = hwpml_attr_uint (n_attributes, attributes, "Header") / 7200.0 * 72;
+        secd->page_footer_margin_in_points = hwpml_attr_uint (n_attributes, attributes, "Footer") / 7200.0 * 72;
+        secd->page_gutter_margin_in_points = hwpml_attr_uint (n_attributes, attributes, "Gutter") / 7200.0 * 72;
+      }
+      break;
+    case HWPML_TAG_TABLE:
+      hwpml_begin_table (context, n_attributes, attributes);
+      break;
+    case HWPML_TAG_INSIDEMARGIN:
+      if (table && !table->cell)
+      {
+        table->table->left_margin   = hwpml_attr_uint16 (n_attributes, attributes, "Left");
+        table->table->right_margin  = hwpml_attr_uint16 (n_attributes, attributes, "Right");
+        table->table->top_margin    = hwpml_attr_uint16 (n_attributes, attributes, "Top");
+        table->table->bottom_margin = hwpml_attr_uint16 (n_attributes, attributes, "Bottom");
+      }
+      break;
+    case HWPML_TAG_CELL:
+      hwpml_begin_cell (context, n_attributes, attributes);
+      break;
+    case HWPML_TAG_CELLMARGIN:
+      if (table && table->cell)
+      {
+        table->cell->left_margin   = hwpml_attr_uint16 (n_attributes, attributes, "Left");
+        table->cell->right_margin  = hwpml_attr_uint16 (n_attributes, attributes, "Right");
+        table->cell->top_margin    = hwpml_attr_uint16 (n_attributes, attributes, "Top");
+        table->cell->bottom_margin = hwpml_attr_uint16 (n_attributes, attributes, "Bottom");
+      }
+      break;
+    case HWPML_TAG_OTHER:
+    default:
+      break;
+  }
+}
+
+static void hwpml_end_element (void          *user_data,
+                               const xmlChar *localname,
+                               const xmlChar *prefix,
+                               const xmlChar *uri)
+{
+  HwpmlContext *context = user_data;
+  HwpSaxPara   *para    = _hwp_sax_top_para (&context->body);
+  HwpSaxTable  *table   = _hwp_sax_top_table (&context->body);
+  HwpHWPMLParserPrivate *priv = context->parser->priv;
+
+  switch (hwpml_tag_lookup (context, localname))
+  {
+    case HWPML_TAG_DOCSUMMARY:
+      context->in_summary = FALSE;
+
+      if (priv->info && context->iface->summary_info)
+        context->iface->summary_info (context->parser->listenable,
+                                      g_object_ref (priv->info),
+                                      context->parser->user_data,
+                                      context->error);
+      break;
+    case HWPML_TAG_TITLE:
+    case HWPML_TAG_SUBJECT:
+    case HWPML_TAG_AUTHOR:
+    case HWPML_TAG_KEYWORDS:
+    case HWPML_TAG_COMMENTS:
+      if (context->field)
+      {
+        g_free (*context->field);
+        *context->field = g_strndup (context->buffer->str, context->buffer->len);
+        g_string_truncate (context->buffer, 0);
+        context->field = NULL;
+      }
+      break;
+    case HWPML_TAG_P:
+      if (para)
+        hwpml_end_paragraph (context);
+      break;
+    case HWPML_TAG_CHAR:
+      if (para && para->in_text)
+        para->in_text--;
+      break;
+    case HWPML_TAG_TABLE:
+      if (table)
+        _hwp_sax_end_table (&context->body);
+      break;
+    case HWPML_TAG_CELL:
+      /* a cell ends only where its own paragraphs are closed */
+      if (table && table->cell && table->depth == context->body.paras->len)
+        _hwp_sax_end_cell (table);
+      break;
+    default:
+      break;
+  }
+}
+
+static void hwpml_characters (void *user_data, const xmlChar *ch, int len)
+{
+  HwpmlContext *context = user_data;
+  HwpSaxPara   *para;
+
+  if (context->field)
+  {
+    g_string_append_len (context->buffer, (const gchar *) ch, len);
+    return;
+  }
+
+  /* 글자는 문단 버퍼 하나에 이어 붙인다 */
+  para = _hwp_sax_top_para (&context->body);
+
+  if (para && para->in_text)
+    g_string_append_len (para->text, (const gchar *) ch, len);
+}
+
+static int read_gsf_input (void *context, char *buffer, int len)
+{
+  GsfInput *input = context;
+  gsf_off_t remaining = gsf_input_remaining (input);
+
+  if (remaining < len)
+    len = (int) remaining;
+
+  if (len > 0 && !gsf_input_read (input, len, (guint8 *) buffer))
+    return -1;
+
+  return len;
+}
+
+static int read_input_stream (void *user_data, char *buffer, int len)
+{
+  HwpmlContext *context = user_data;
+
+  return (int) g_input_stream_read (context->stream, buffer, len,
+                                    context->parser->cancellable, NULL);
+}
+
 /**
  * hwp_hwpml_parser_parse:
  * @parser: a #HwpHWPMLParser
@@ -56,119 +452,96 @@ void hwp_hwpml_parser_parse (HwpHWPMLParser *parser,
 {
   g_return_if_fail (HWP_IS_HWPML_PARSER (parser));
 
-  gchar *uri = file->priv->uri;
+  const gchar     *uri;
+  GInputStream    *stream = NULL;
+  HwpSaxMemory     memory;
+  xmlSAXHandler    sax;
+  xmlParserCtxtPtr ctxt;
+  HwpmlContext     context;
+  GError          *tmp_error = NULL;
+
+  if (file->priv->input)
+    uri = gsf_input_name (file->priv->input);
+  else
+    uri = "(stream)";
 
-  int ret;
+  /* read_input_stream () 는 문서를 만들 때부터 불릴 수 있다 */
+  context.parser = parser;
+  context.stream = NULL;
 
-  xmlTextReaderPtr reader = xmlNewTextReaderFilename (uri);
+  memset (&sax, 0, sizeof sax);
+  sax.initialized    = XML_SAX2_MAGIC;
+  sax.startElementNs = hwpml_start_element;
+  sax.endElementNs   = hwpml_end_element;
+  sax.characters     = hwpml_characters;
 
-  if (reader == NULL)
+  if (file->priv->bytes && file->priv->is_gzip) {
+    /* 압축된 문서는 메모리에서 풀면서 읽는다 */
+    GInputStream      *mis = g_memory_input_stream_new_from_bytes (file->priv->bytes);
+    GZlibDecompressor *zd  = g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP);
+    stream = g_converter_input_stream_new (mis, G_CONVERTER (zd));
+    g_object_unref (zd);
+    g_object_unref (mis);
+    context.stream = stream;
+    ctxt = xmlCreateIOParserCtxt (&sax, &context, read_input_stream, NULL,
+                                  &context, XML_CHAR_ENCODING_NONE);
+  } else if (file->priv->bytes) {
+    gsize size;
+    memory.pos = g_bytes_get_data (file->priv->bytes, &size);
+    memory.end = memory.pos + size;
+    ctxt = xmlCreateIOParserCtxt (&sax, &context, _hwp_sax_read_memory, NULL,
+                                  &memory, XML_CHAR_ENCODING_NONE);
+  } else if (file->priv->input) {
+    /* the input may have been read by an earlier parse */
+    gsf_input_seek (file->priv->input, 0, G_SEEK_SET);
+    ctxt = xmlCreateIOParserCtxt (&sax, &context, read_gsf_input, NULL,
+                                  file->priv->input, XML_CHAR_ENCODING_NONE);
+  } else {
+    /* a stream can be read only once */
+    stream = g_object_ref (file->priv->stream);
+    context.stream = stream;
+    ctxt = xmlCreateIOParserCtxt (&sax, &context, read_input_stream, NULL,
+                                  &context, XML_CHAR_ENCODING_NONE);
+  }
+
+  if (ctxt == NULL)
   {
     g_warning ("Unable to open %s\n", uri);
+    g_clear_object (&stream);
     return;
   }
 
-  HwpParseState parse_state = HWP_PARSE_STATE_NORMAL;
-  guint tag_p_count = 0;
-  HwpParagraph *paragraph = NULL;
-  HwpListenableInterface *iface;
-  iface = HWP_LISTENABLE_GET_IFACE (parser->listenable);
+  /* 외부 엔티티와 네트워크는 쓰지 않는다 */
+  xmlCtxtUseOptions (ctxt, XML_PARSE_NONET | XML_PARSE_NOWARNING);
 
-  gchar *tag_docsummary = g_utf8_casefold ("DOCSUMMARY", strlen("DOCSUMMARY"));
-  gchar *tag_p          = g_utf8_casefold ("P",          strlen("P"));
-  gchar *tag_text       = g_utf8_casefold ("TEXT",       strlen("TEXT"));
-  gchar *tag_char       = g_utf8_casefold ("CHAR",       strlen("CHAR"));
+  context.iface      = HWP_LISTENABLE_GET_IFACE (parser->listenable);
+  context.ctxt       = ctxt;
+  context.error      = &tmp_error;
+  context.tags       = g_hash_table_new (g_direct_hash, g_direct_equal);
+  _hwp_sax_body_init (&context.body);
+  context.in_summary = FALSE;
+  context.field      = NULL;
+  context.buffer     = g_string_new (NULL);
+  context.stopped    = FALSE;
+  context.events     = hwp_listenable_get_event_mask (parser->listenable);
 
-  while ((ret = xmlTextReaderRead (reader)) == 1)
-  {
-    xmlChar *name  = xmlTextReaderName (reader);
-    xmlChar *value = xmlTextReaderValue (reader);
-    int node_type  = xmlTextReaderNodeType (reader);
-
-    gchar *tag_name = g_utf8_casefold ((const char *) name,
-                                       strlen ((const char *) name));
-
-    switch (node_type)
-    {
-      case XML_READER_TYPE_ELEMENT:
-        /* document summary */
-        if (g_utf8_collate (tag_name, tag_docsummary) == 0)
-        {
-          parse_state = HWP_PARSE_STATE_DOCSUMMARY;
-          parser->priv->info = hwp_summary_info_new ();
-        /* paragraph */
-        }
-        else if (g_utf8_collate (tag_name, tag_p) == 0)
-        {
-          parse_state = HWP_PARSE_STATE_P;
-          tag_p_count++;
-          if (tag_p_count > 1)
-            paragraph = hwp_paragraph_new ();
-        /* char */
-        }
-        else if (g_utf8_collate (tag_name, tag_char) == 0)
-        {
-          parse_state = HWP_PARSE_STATE_CHAR;
-        }
-        break;
-      case XML_READER_TYPE_TEXT:
-        if (parse_state == HWP_PARSE_STATE_CHAR)
-        {
-          if (paragraph)
-            paragraph->text = g_strdup ((const char *) value);
-        }
-        break;
-      case XML_READER_TYPE_END_ELEMENT:
-        if (g_utf8_collate (tag_name, tag_docsummary) == 0)
-        {
-          parse_state = HWP_PARSE_STATE_NORMAL;
-
-          if (iface->summary_info)
-            iface->summary_info (parser->listenable,
-                                 g_object_ref (parser->priv->info),
-                                 parser->user_data,
-                                 error);
-        }
-        else if ((g_utf8_collate (tag_name, tag_p) == 0) && (tag_p_count > 1))
-        {
-          if (iface->paragraph)
-          {
-            iface->paragraph (parser->listenable,
-                              paragraph,
-                              parser->user_data,
-                              error);
-          }
-          else
-          {
-            g_object_unref (paragraph);
-            paragraph = NULL;
-          }
-        }
-        else if (g_utf8_collate (tag_name, tag_char) == 0)
-        {
-          parse_state = HWP_PARSE_STATE_NORMAL;
-        }
-        break;
-      case -1:
-        /* TODO: error handling */
-      default:
-        break;
-    } /* switch */
-
-    g_free  (tag_name);
-    xmlFree (name);
-    xmlFree (value);
-  }
-
-  g_free (tag_docsummary);
-  g_free (tag_p);
-  g_free (tag_text);
-  g_free (tag_char);
+  xmlParseDocument (ctxt);
 
-  xmlFreeTextReader (reader);
+  /* 읽는 도중에 취소되었으면 libxml2 는 읽기 오류로만 안다 */
+  if (!tmp_error)
+    g_cancellable_set_error_if_cancelled (parser->cancellable, &tmp_error);
 
-  if (ret != 0)
+  if (!ctxt->wellFormed && !context.stopped && !tmp_error)
     g_warning ("%s : failed to parse\n", uri);
+
+  _hwp_sax_body_clear (&context.body);
+  g_hash_table_destroy (context.tags);
+  g_string_free (context.buffer, TRUE);
+  xmlFreeParserCtxt (ctxt);
+  g_clear_object (&stream);
+
+  if (tmp_error)
+    g_propagate_error (error, tmp_error);
 }
 
 static void hwp_hwpml_parser_finalize (GObject *object)
@@ -186,6 +559,9 @@ static void hwp_hwpml_parser_class_init (HwpHWPMLParserClass *klass)
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
   g_type_class_add_private (klass, sizeof (HwpHWPMLParserPrivate));
   object_class->finalize = hwp_hwpml_parser_finalize;
+  /* libxml2 must be initialized once before readers run on other threads;
+   * class_init is run exactly once, under the GType lock */
+  xmlInitParser ();
 }
 
 static void hwp_hwpml_parser_init (HwpHWPMLParser *parser)
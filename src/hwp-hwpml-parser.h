@@ -43,6 +43,7 @@
 #define __HWP_HWPML_PARSER_H__
 
 #include <glib-object.h>
+#include "hwp-enums.h"
 #include "hwp-listenable.h"
 #include "hwp-hwpml-file.h"
 
@@ -66,6 +67,9 @@ struct _HwpHWPMLParser
 
   HwpListenable         *listenable;
   gpointer               user_data;
+  HwpParseFlags          flags;
+  /* checked between elements; not referenced */
+  GCancellable          *cancellable;
 };
 
 /**
@@ -0,0 +1,629 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/*
+ * hwp-hwpx-file.c
+ * This file is part of the libhwp project.
+ *
+ * Copyright (C) 2016 Hodong Kim <cogniti@gmail.com>
+ *
+ * The libhwp is dual licensed under the LGPL v3+ or Apache License 2.0
+ *
+ * The libhwp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The libhwp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program;  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Or,
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * HWPX (OWPML) documents are zip packages.  The central directory is read
+ * from memory and members are never extracted to disk: each section is
+ * inflated as it is read, through a GZlibDecompressor over the compressed
+ * bytes of the member.  The package bytes are never modified, so streams
+ * of different sections can be read on different threads at once.
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <glib/gi18n-lib.h>
+#include <gsf/gsf-input-stdio.h>
+#include <gsf/gsf-utils.h>
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+
+#include "hwp-enums.h"
+#include "hwp-file-private.h"
+#include "hwp-hwpx-file.h"
+#include "hwp-inflate.h"
+
+G_DEFINE_TYPE (HwpHWPXFile, hwp_hwpx_file, HWP_TYPE_FILE);
+
+#define ZIP_LOCAL_HEADER_SIG   0x04034b50
+#define ZIP_CENTRAL_HEADER_SIG 0x02014b50
+#define ZIP_END_OF_CD_SIG      0x06054b50
+
+#define ZIP_METHOD_STORED      0
+#define ZIP_METHOD_DEFLATED    8
+
+/* _hwp_hwpx_file_get_entry_bytes() 로 읽는 메타데이터 파일의 상한 */
+#define ENTRY_BYTES_MAX        (16 * 1024 * 1024)
+
+typedef struct
+{
+  guint16 method;
+  guint32 compressed_size;
+  guint32 size;
+  gsize   offset; /* of the member data, past the local header */
+} HwpZipEntry;
+
+typedef struct
+{
+  guint        number;
+  HwpZipEntry *entry;
+} SectionEntry;
+
+static void zip_entry_free (gpointer entry)
+{
+  g_slice_free (HwpZipEntry, entry);
+}
+
+static gint section_entry_cmp (gconstpointer a, gconstpointer b)
+{
+  const SectionEntry *x = a;
+  const SectionEntry *y = b;
+
+  return (x->number > y->number) - (x->number < y->number);
+}
+
+/* "Contents/section0.xml", "Contents/section1.xml", ... */
+static gboolean parse_section_name (const gchar *name, guint *number)
+{
+  const gchar *p = name + strlen ("Contents/section");
+  guint        n = 0;
+
+  if (!g_str_has_prefix (name, "Contents/section") || !g_ascii_isdigit (*p))
+    return FALSE;
+
+  while (g_ascii_isdigit (*p))
+    n = n * 10 + (*p++ - '0');
+
+  if (strcmp (p, ".xml") != 0)
+    return FALSE;
+
+  *number = n;
+
+  return TRUE;
+}
+
+static gboolean read_central_directory (HwpHWPXFile *file, GError **error)
+{
+  gsize         size;
+  const guint8 *data = g_bytes_get_data (file->priv->bytes, &size);
+  const guint8 *eocd = NULL;
+  const guint8 *p;
+  const guint8 *end;
+  guint16       n_entries;
+  guint32       cd_size;
+  guint32       cd_offset;
+  GArray       *sections;
+
+  /* the end of central directory record is followed by a comment of
+   * at most 64 KiB */
+  if (size >= 22)
+  {
+    gsize i     = size - 22;
+    gsize limit = size > 22 + 0xffff ? size - 22 - 0xffff : 0;
+
+    for (;; i--)
+    {
+      if (GSF_LE_GET_GUINT32 (data + i) == ZIP_END_OF_CD_SIG)
+      {
+        eocd = data + i;
+        break;
+      }
+
+      if (i == limit)
+        break;
+    }
+  }
+
+  if (!eocd)
+    goto CORRUPTED;
+
+  n_entries = GSF_LE_GET_GUINT16 (eocd + 10);
+  cd_size   = GSF_LE_GET_GUINT32 (eocd + 12);
+  cd_offset = GSF_LE_GET_GUINT32 (eocd + 16);
+
+  if ((gsize) cd_offset + cd_size > size)
+    goto CORRUPTED;
+
+  p        = data + cd_offset;
+  end      = p + cd_size;
+  sections = g_array_new (FALSE, FALSE, sizeof (SectionEntry));
+
+  for (guint i = 0; i < n_entries; i++)
+  {
+    HwpZipEntry *entry;
+    guint16      name_len;
+    gsize        local;
+    gchar       *name;
+    SectionEntry section;
+
+    if (end - p < 46 || GSF_LE_GET_GUINT32 (p) != ZIP_CENTRAL_HEADER_SIG)
+      goto CORRUPTED_SECTIONS;
+
+    name_len = GSF_LE_GET_GUINT16 (p + 28);
+
+    if ((gsize) (end - p) < 46 + (gsize) name_len)
+      goto CORRUPTED_SECTIONS;
+
+    name = g_strndup ((const gchar *) p + 46, name_len);
+
+    /* 같은 이름이 두 번 나오면 먼저 것을 sections 가 가리키고 있다 */
+    if (g_hash_table_contains (file->priv->entries, name))
+    {
+      g_free (name);
+      goto CORRUPTED_SECTIONS;
+    }
+
+    entry = g_slice_new (HwpZipEntry);
+    entry->method          = GSF_LE_GET_GUINT16 (p + 10);
+    entry->compressed_size = GSF_LE_GET_GUINT32 (p + 20);
+    entry->size            = GSF_LE_GET_GUINT32 (p + 24);
+    local                  = GSF_LE_GET_GUINT32 (p + 42);
+
+    /* 로컬 헤더의 extra field 길이는 중앙 디렉터리와 다를 수 있다 */
+    if (local + 30 > size ||
+        GSF_LE_GET_GUINT32 (data + local) != ZIP_LOCAL_HEADER_SIG)
+    {
+      zip_entry_free (entry);
+      g_free (name);
+      goto CORRUPTED_SECTIONS;
+    }
+
+    entry->offset = local + 30 + GSF_LE_GET_GUINT16 (data + local + 26)
+                               + GSF_LE_GET_GUINT16 (data + local + 28);
+
+    if (entry->offset + entry->compressed_size > size)
+    {
+      zip_entry_free (entry);
+      g_free (name);
+      goto CORRUPTED_SECTIONS;
+    }
+
+    if (parse_section_name (name, &section.number))
+    {
+      section.entry = entry;
+      g_array_append_val (sections, section);
+    }
+
+    g_hash_table_insert (file->priv->entries, name, entry);
+
+    p += 46 + name_len + GSF_LE_GET_GUINT16 (p + 30)
+                       + GSF_LE_GET_GUINT16 (p + 32);
+  }
+
+  g_array_sort (sections, section_entry_cmp);
+
+  for (guint i = 0; i < sections->len; i++)
+    g_ptr_array_add (file->priv->sections,
+                     g_array_index (sections, SectionEntry, i).entry);
+
+  g_array_free (sections, TRUE);
+
+  return TRUE;
+
+  CORRUPTED_SECTIONS:
+  g_array_free (sections, TRUE);
+
+  CORRUPTED:
+  g_set_error_literal (error, HWP_ERROR, HWP_ERROR_INVALID,
+                       _("File corrupted"));
+  return FALSE;
+}
+
+/* a stream of the uncompressed contents of @entry */
+static GInputStream *open_entry (HwpHWPXFile  *file,
+                                 HwpZipEntry  *entry,
+                                 GError      **error)
+{
+  GBytes       *slice;
+  GInputStream *stream;
+
+  if (entry->method != ZIP_METHOD_STORED &&
+      entry->method != ZIP_METHOD_DEFLATED)
+  {
+    g_set_error (error, HWP_ERROR, HWP_ERROR_INVALID,
+                 _("Unsupported compression method %d"), entry->method);
+    return NULL;
+  }
+
+  slice  = g_bytes_new_from_bytes (file->priv->bytes, entry->offset,
+                                   entry->compressed_size);
+  stream = g_memory_input_stream_new_from_bytes (slice);
+  g_bytes_unref (slice);
+
+  if (entry->method == ZIP_METHOD_DEFLATED)
+  {
+    GZlibDecompressor *zd;
+    GInputStream      *cis;
+
+    zd  = g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW);
+    cis = g_converter_input_stream_new (stream, G_CONVERTER (zd));
+    g_object_unref (zd);
+    g_object_unref (stream);
+    stream = cis;
+  }
+
+  return stream;
+}
+
+/*
+ * Returns the uncompressed contents of the member @name, or %NULL without
+ * setting @error if there is no such member.  For the small members
+ * (version.xml, Contents/content.hpf, Preview/PrvText.txt); a member that
+ * inflates to more than ENTRY_BYTES_MAX is rejected.
+ */
+GBytes *_hwp_hwpx_file_get_entry_bytes (HwpHWPXFile *file,
+                                        const gchar *name,
+                                        GError     **error)
+{
+  g_return_val_if_fail (HWP_IS_HWPX_FILE (file), NULL);
+
+  HwpZipEntry  *entry = g_hash_table_lookup (file->priv->entries, name);
+  gsize         size;
+  gsize         hint;
+  const guint8 *data  = g_bytes_get_data (file->priv->bytes, &size);
+
+  if (!entry)
+    return NULL;
+
+  switch (entry->method)
+  {
+    case ZIP_METHOD_STORED:
+      if (entry->compressed_size > ENTRY_BYTES_MAX)
+        break;
+
+      return g_bytes_new_from_bytes (file->priv->bytes, entry->offset,
+                                     entry->compressed_size);
+    case ZIP_METHOD_DEFLATED:
+      /* 중앙 디렉터리의 size 는 믿지 않고 압축된 크기로 가늠한다 */
+      hint = MIN ((gsize) entry->size,
+                  MAX ((gsize) entry->compressed_size * 4, 4096));
+
+      return _hwp_inflate_raw (data + entry->offset, entry->compressed_size,
+                               hint, ENTRY_BYTES_MAX, error);
+    default:
+      g_set_error (error, HWP_ERROR, HWP_ERROR_INVALID,
+                   _("Unsupported compression method %d"), entry->method);
+      return NULL;
+  }
+
+  g_set_error_literal (error, HWP_ERROR, HWP_ERROR_INVALID,
+                       _("Decompressed data is too large"));
+  return NULL;
+}
+
+static guint8 get_version_attr (xmlNodePtr node, const char *name)
+{
+  xmlChar *value = xmlGetProp (node, BAD_CAST name);
+  guint8   retval;
+
+  if (!value)
+    return 0;
+
+  retval = (guint8) g_ascii_strtoull ((const gchar *) value, NULL, 10);
+  xmlFree (value);
+
+  return retval;
+}
+
+/* <hv:HCFVersion major="5" minor="1" micro="0" buildNumber="1" ... /> */
+static void parse_version (HwpHWPXFile *file)
+{
+  GBytes       *bytes = _hwp_hwpx_file_get_entry_bytes (file, "version.xml",
+                                                        NULL);
+  gsize         size;
+  const char   *data;
+  xmlDocPtr     doc;
+  xmlNodePtr    root;
+
+  if (!bytes)
+    return;
+
+  data = g_bytes_get_data (bytes, &size);
+  doc  = xmlReadMemory (data, (int) size, "version.xml", NULL,
+                        XML_PARSE_NONET | XML_PARSE_NOERROR |
+                        XML_PARSE_NOWARNING);
+
+  if (doc && (root = xmlDocGetRootElement (doc)))
+  {
+    file->major_version = get_version_attr (root, "major");
+    file->minor_version = get_version_attr (root, "minor");
+    file->micro_version = get_version_attr (root, "micro");
+    file->extra_version = get_version_attr (root, "buildNumber");
+  }
+
+  if (doc)
+    xmlFreeDoc (doc);
+
+  g_bytes_unref (bytes);
+}
+
+static HwpHWPXFile *hwp_hwpx_file_new_take_bytes (GBytes  *bytes,
+                                                  GError **error)
+{
+  HwpHWPXFile *file = g_object_new (HWP_TYPE_HWPX_FILE, NULL);
+  file->priv->bytes = bytes;
+
+  if (!read_central_directory (file, error))
+  {
+    g_object_unref (file);
+    return NULL;
+  }
+
+  parse_version (file);
+
+  return file;
+}
+
+HwpHWPXFile *_hwp_hwpx_file_new_for_gsf_input (GsfInput *input,
+                                              GError  **error)
+{
+  gsf_off_t size;
+  guint8   *data;
+
+  /* 파일이면 hwp_hwpx_file_new_for_path () 처럼 복사하지 않고 매핑한다 */
+  if (GSF_IS_INPUT_STDIO (input))
+  {
+    gchar       *path   = g_filename_from_utf8 (gsf_input_name (input), -1,
+                                                NULL, NULL, NULL);
+    GMappedFile *mapped = path ? g_mapped_file_new (path, FALSE, NULL) : NULL;
+
+    g_free (path);
+
+    if (mapped)
+    {
+      GBytes *bytes = g_mapped_file_get_bytes (mapped);
+      g_mapped_file_unref (mapped);
+
+      return hwp_hwpx_file_new_take_bytes (bytes, error);
+    }
+  }
+
+  size = gsf_input_size (input);
+  data = g_try_malloc (size);
+
+  if (size > 0 && (!data || !gsf_input_read (input, size, data)))
+  {
+    g_free (data);
+    g_set_error (error, HWP_FILE_ERROR, HWP_FILE_ERROR_FAILED,
+                        "failed to read %s", gsf_input_name (input));
+    return NULL;
+  }
+
+  return hwp_hwpx_file_new_take_bytes (g_bytes_new_take (data, size), error);
+}
+
+/**
+ * hwp_hwpx_file_new_for_path:
+ * @path: path of the file to load
+ * @error: location to store the error occurring, or %NULL to ignore
+ *
+ * Creates a new #HwpHWPXFile.  The package is memory mapped and its
+ * members are inflated as they are parsed, never extracted to disk.
+ * If %NULL is returned, then @error will be set. Possible errors include
+ * those in the #G_FILE_ERROR, #HWP_ERROR and #HWP_FILE_ERROR domains.
+ *
+ * Return value: A newly created #HwpHWPXFile, or %NULL
+ *
+ * Since: 2016.06.01
+ */
+HwpHWPXFile *hwp_hwpx_file_new_for_path (const gchar *path, GError **error)
+{
+  g_return_val_if_fail (path != NULL, NULL);
+
+  GMappedFile *mapped = g_mapped_file_new (path, FALSE, error);
+
+  if (!mapped)
+    return NULL;
+
+  /* GBytes 가 mapping 에 대한 참조를 유지한다 */
+  GBytes *bytes = g_mapped_file_get_bytes (mapped);
+  g_mapped_file_unref (mapped);
+
+  return hwp_hwpx_file_new_take_bytes (bytes, error);
+}
+
+/**
+ * hwp_hwpx_file_new_for_uri:
+ * @uri: a UTF-8 string containing a URI
+ * @error: location to store the error occurring, or %NULL to ignore
+ *
+ * Creates a new #HwpHWPXFile.  If %NULL is returned, then @error will be
+ * set. Possible errors include those in the #G_IO_ERROR, #HWP_ERROR and
+ * #HWP_FILE_ERROR domains.
+ *
+ * Return value: A newly created #HwpHWPXFile, or %NULL
+ *
+ * Since: 2016.06.01
+ */
+HwpHWPXFile *hwp_hwpx_file_new_for_uri (const gchar *uri, GError **error)
+{
+  g_return_val_if_fail (uri != NULL, NULL);
+
+  GFile    *gfile = g_file_new_for_uri (uri);
+  gchar    *data;
+  gsize     size;
+  gboolean  loaded;
+
+  loaded = g_file_load_contents (gfile, NULL, &data, &size, NULL, error);
+  g_object_unref (gfile);
+
+  if (!loaded)
+    return NULL;
+
+  return hwp_hwpx_file_new_take_bytes (g_bytes_new_take (data, size), error);
+}
+
+/**
+ * hwp_hwpx_file_new_for_bytes:
+ * @bytes: a #GBytes containing the whole package
+ * @error: location to store the error occurring, or %NULL to ignore
+ *
+ * Creates a new #HwpHWPXFile which reads the package directly from
+ * @bytes, without copying it. If %NULL is returned, then @error will be
+ * set. Possible errors include those in the #HWP_ERROR and #HWP_FILE_ERROR
+ * domains.
+ *
+ * Return value: A newly created #HwpHWPXFile, or %NULL
+ *
+ * Since: 2016.06.01
+ */
+HwpHWPXFile *hwp_hwpx_file_new_for_bytes (GBytes *bytes, GError **error)
+{
+  g_return_val_if_fail (bytes != NULL, NULL);
+
+  return hwp_hwpx_file_new_take_bytes (g_bytes_ref (bytes), error);
+}
+
+/**
+ * hwp_hwpx_file_get_n_sections:
+ * @file: a #HwpHWPXFile
+ *
+ * Returns: the number of Contents/section*.xml members
+ *
+ * Since: 2016.06.01
+ */
+guint hwp_hwpx_file_get_n_sections (HwpHWPXFile *file)
+{
+  g_return_val_if_fail (HWP_IS_HWPX_FILE (file), 0);
+
+  return file->priv->sections->len;
+}
+
+/**
+ * hwp_hwpx_file_get_section_stream:
+ * @file: a #HwpHWPXFile
+ * @index: the index of the section
+ * @error: location to store the error occurring, or %NULL to ignore
+ *
+ * Opens the XML of a section, inflated as it is read.  Each call returns
+ * a new stream; streams of different sections may be read on different
+ * threads at the same time.
+ *
+ * Return value: (transfer full): a new #GInputStream, or %NULL
+ *
+ * Since: 2016.06.01
+ */
+GInputStream *hwp_hwpx_file_get_section_stream (HwpHWPXFile *file,
+                                                guint        index,
+                                                GError     **error)
+{
+  g_return_val_if_fail (HWP_IS_HWPX_FILE (file), NULL);
+  g_return_val_if_fail (index < file->priv->sections->len, NULL);
+
+  return open_entry (file, g_ptr_array_index (file->priv->sections, index),
+                     error);
+}
+
+/**
+ * hwp_hwpx_file_get_hwp_version_string:
+ * @file: a #HwpFile
+ *
+ * Returns: the major, minor, micro and build version string of the
+ *   application that wrote the document
+ *
+ * Since: 2016.06.01
+ */
+gchar *hwp_hwpx_file_get_hwp_version_string (HwpFile *file)
+{
+  g_return_val_if_fail (HWP_IS_HWPX_FILE (file), NULL);
+
+  return g_strdup_printf ("%d.%d.%d.%d", HWP_HWPX_FILE (file)->major_version,
+                                         HWP_HWPX_FILE (file)->minor_version,
+                                         HWP_HWPX_FILE (file)->micro_version,
+                                         HWP_HWPX_FILE (file)->extra_version);
+}
+
+/**
+ * hwp_hwpx_file_get_hwp_version:
+ * @file: a #HwpFile
+ * @major_version: (out) (allow-none): return location for the HWP major version number
+ * @minor_version: (out) (allow-none): return location for the HWP minor version number
+ * @micro_version: (out) (allow-none): return location for the HWP micro version number
+ * @extra_version: (out) (allow-none): return location for the HWP extra version number
+ *
+ * Since: 2016.06.01
+ */
+void hwp_hwpx_file_get_hwp_version (HwpFile *file,
+                                    guint8  *major_version,
+                                    guint8  *minor_version,
+                                    guint8  *micro_version,
+                                    guint8  *extra_version)
+{
+  g_return_if_fail (HWP_IS_HWPX_FILE (file));
+
+  if (major_version) *major_version = HWP_HWPX_FILE (file)->major_version;
+  if (minor_version) *minor_version = HWP_HWPX_FILE (file)->minor_version;
+  if (micro_version) *micro_version = HWP_HWPX_FILE (file)->micro_version;
+  if (extra_version) *extra_version = HWP_HWPX_FILE (file)->extra_version;
+}
+
+static void hwp_hwpx_file_init (HwpHWPXFile *file)
+{
+  file->priv = G_TYPE_INSTANCE_GET_PRIVATE (file, HWP_TYPE_HWPX_FILE,
+                                                  HwpHWPXFilePrivate);
+  file->priv->entries  = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                g_free, zip_entry_free);
+  file->priv->sections = g_ptr_array_new ();
+}
+
+static void hwp_hwpx_file_finalize (GObject *object)
+{
+  HwpHWPXFile *file = HWP_HWPX_FILE (object);
+
+  if (file->priv->bytes)
+    g_bytes_unref (file->priv->bytes);
+
+  g_hash_table_destroy (file->priv->entries);
+  g_ptr_array_unref (file->priv->sections);
+
+  G_OBJECT_CLASS (hwp_hwpx_file_parent_class)->finalize (object);
+}
+
+static void hwp_hwpx_file_class_init (HwpHWPXFileClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  HwpFileClass *file_class   = HWP_FILE_CLASS (klass);
+
+  g_type_class_add_private (klass, sizeof (HwpHWPXFilePrivate));
+  file_class->get_hwp_version_string = hwp_hwpx_file_get_hwp_version_string;
+  file_class->get_hwp_version        = hwp_hwpx_file_get_hwp_version;
+  object_class->finalize = hwp_hwpx_file_finalize;
+  /* parse_version () reads version.xml before any parser class exists;
+   * libxml2 must be initialized once before files are opened on several
+   * threads, and class_init is run exactly once, under the GType lock */
+  xmlInitParser ();
+}
@@ -0,0 +1,119 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/*
+ * hwp-hwpx-file.h
+ * This file is part of the libhwp project.
+ *
+ * Copyright (C) 2016 Hodong Kim <cogniti@gmail.com>
+ *
+ * The libhwp is dual licensed under the LGPL v3+ or Apache License 2.0
+ *
+ * The libhwp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The libhwp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program;  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Or,
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * This software has been developed with reference to
+ * the HWP file format open specification by Hancom, Inc.
+ * http://www.hancom.co.kr/userofficedata.userofficedataList.do?menuFlag=3
+ * 한글과컴퓨터의 한/글 문서 파일(.hwp) 공개 문서를 참고하여 개발하였습니다.
+ */
+
+#if !defined (__HWP_H_INSIDE__) && !defined (HWP_COMPILATION)
+#error "Only <hwp/hwp.h> can be included directly."
+#endif
+
+#ifndef __HWP_HWPX_FILE_H__
+#define __HWP_HWPX_FILE_H__
+
+#include <glib-object.h>
+#include <gio/gio.h>
+
+#include "hwp-file.h"
+
+G_BEGIN_DECLS
+
+#define HWP_TYPE_HWPX_FILE             (hwp_hwpx_file_get_type ())
+#define HWP_HWPX_FILE(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), HWP_TYPE_HWPX_FILE, HwpHWPXFile))
+#define HWP_HWPX_FILE_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST ((klass), HWP_TYPE_HWPX_FILE, HwpHWPXFileClass))
+#define HWP_IS_HWPX_FILE(obj)          (G_TYPE_CHECK_INSTANCE_TYPE ((obj), HWP_TYPE_HWPX_FILE))
+#define HWP_IS_HWPX_FILE_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), HWP_TYPE_HWPX_FILE))
+#define HWP_HWPX_FILE_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), HWP_TYPE_HWPX_FILE, HwpHWPXFileClass))
+
+typedef struct _HwpHWPXFile        HwpHWPXFile;
+typedef struct _HwpHWPXFileClass   HwpHWPXFileClass;
+typedef struct _HwpHWPXFilePrivate HwpHWPXFilePrivate;
+
+struct _HwpHWPXFile
+{
+  HwpFile             parent_instance;
+  HwpHWPXFilePrivate *priv;
+
+  guint8              major_version;
+  guint8              minor_version;
+  guint8              micro_version;
+  guint8              extra_version;
+};
+
+/**
+ * HwpHWPXFileClass:
+ * @parent_class: the parent class
+ *
+ * The class structure for the <structname>HwpHWPXFile</structname> type.
+ */
+struct _HwpHWPXFileClass
+{
+  HwpFileClass parent_class;
+};
+
+struct _HwpHWPXFilePrivate
+{
+  GBytes     *bytes;    /* the whole zip package */
+  GHashTable *entries;  /* member name -> zip entry */
+  GPtrArray  *sections; /* entries of Contents/section*.xml, in order */
+};
+
+GType         hwp_hwpx_file_get_type               (void) G_GNUC_CONST;
+HwpHWPXFile  *hwp_hwpx_file_new_for_path           (const gchar *path,
+                                                    GError     **error);
+HwpHWPXFile  *hwp_hwpx_file_new_for_uri            (const gchar *uri,
+                                                    GError     **error);
+HwpHWPXFile  *hwp_hwpx_file_new_for_bytes          (GBytes      *bytes,
+                                                    GError     **error);
+guint         hwp_hwpx_file_get_n_sections         (HwpHWPXFile *file);
+GInputStream *hwp_hwpx_file_get_section_stream     (HwpHWPXFile *file,
+                                                    guint        index,
+                                                    GError     **error);
+gchar        *hwp_hwpx_file_get_hwp_version_string (HwpFile     *file);
+void          hwp_hwpx_file_get_hwp_version        (HwpFile     *file,
+                                                    guint8      *major_version,
+                                                    guint8      *minor_version,
+                                                    guint8      *micro_version,
+                                                    guint8      *extra_version);
+
+G_END_DECLS
+
+#endif /* __HWP_HWPX_FILE_H__ */
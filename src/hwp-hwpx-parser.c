@@ -0,0 +1,936 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/*
+ * hwp-hwpx-parser.c
+ * This file is part of the libhwp project.
+ *
+ * Copyright (C) 2016 Hodong Kim <cogniti@gmail.com>
+ *
+ * The libhwp is dual licensed under the LGPL v3+ or Apache License 2.0
+ *
+ * The libhwp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The libhwp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program;  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Or,
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hwp-hwpx-parser.h"
+#include <libxml/parser.h>
+#include "hwp-enums.h"
+#include "hwp-file-private.h"
+#include "hwp-sax-body.h"
+#include <string.h>
+
+G_DEFINE_TYPE (HwpHWPXParser, hwp_hwpx_parser, G_TYPE_OBJECT)
+
+/*
+ * The sections of an HWPX package, Contents/section*.xml, are parsed with
+ * the SAX2 interface of libxml2 as they are inflated, like HWPML.  They
+ * are independent documents, so with HWP_PARSE_FLAGS_PARALLEL_SECTIONS
+ * each one is parsed on a thread pool and its paragraphs are handed to
+ * the listener from the calling thread, as the HWP 5.0 parser does.
+ */
+
+typedef enum {
+  HWPX_TAG_OTHER,
+  HWPX_TAG_P,
+  HWPX_TAG_RUN,
+  HWPX_TAG_T,
+  HWPX_TAG_TAB,
+  HWPX_TAG_LINEBREAK,
+  HWPX_TAG_SECPR,
+  HWPX_TAG_PAGEPR,
+  HWPX_TAG_MARGIN,
+  HWPX_TAG_TBL,
+  HWPX_TAG_INMARGIN,
+  HWPX_TAG_TC,
+  HWPX_TAG_CELLADDR,
+  HWPX_TAG_CELLSPAN,
+  HWPX_TAG_CELLSZ,
+  HWPX_TAG_CELLMARGIN,
+  HWPX_TAG_NOTE,  /* header, footer, footnote, endnote, hidden comment */
+  HWPX_TAG_SHAPE, /* drawing objects and pictures */
+  HWPX_TAG_N
+} HwpxTag;
+
+/* local names; OWPML names are case sensitive */
+static const gchar * const hwpx_tag_names[HWPX_TAG_N] =
+{
+  NULL,
+  "p",
+  "run",
+  "t",
+  "tab",
+  "lineBreak",
+  "secPr",
+  "pagePr",
+  "margin",
+  "tbl",
+  "inMargin",
+  "tc",
+  "cellAddr",
+  "cellSpan",
+  "cellSz",
+  "cellMargin"
+};
+
+static const gchar * const hwpx_note_names[] =
+{
+  "header", "footer", "footNote", "endNote", "hiddenComment", NULL
+};
+
+static const gchar * const hwpx_shape_names[] =
+{
+  "container", "line", "rect", "ellipse", "arc", "polygon", "curve",
+  "connectLine", "pic", "ole", "equation", "textart", NULL
+};
+
+typedef struct {
+  HwpHWPXParser    *parser;
+  xmlParserCtxtPtr  ctxt;
+  GError          **error;  /* never NULL */
+  GInputStream     *stream; /* read by read_input_stream () */
+  guint             section_index;
+
+  /* top level paragraphs go to the listener, or are collected by a
+   * worker thread */
+  void            (*sink) (HwpParagraph *, gpointer, GError **);
+  gpointer          sink_data;
+
+  GHashTable       *tags;   /* interned name -> HwpxTag */
+  HwpSaxBody        body;
+  gboolean          in_page_pr;
+  HwpEventMask      events;
+  guint             skip;   /* depth inside an element being skipped */
+  gboolean          stopped;
+} HwpxContext;
+
+static HwpxTag hwpx_tag_lookup (HwpxContext *context, const xmlChar *name)
+{
+  gpointer value;
+  guint    i;
+
+  /* libxml2 interns element names in the dictionary of the parser */
+  if (g_hash_table_lookup_extended (context->tags, name, NULL, &value))
+    return GPOINTER_TO_UINT (value);
+
+  for (i = 1; i < HWPX_TAG_NOTE; i++)
+    if (strcmp ((const gchar *) name, hwpx_tag_names[i]) == 0)
+      break;
+
+  if (i == HWPX_TAG_NOTE)
+  {
+    if (g_strv_contains (hwpx_note_names, (const gchar *) name))
+      i = HWPX_TAG_NOTE;
+    else if (g_strv_contains (hwpx_shape_names, (const gchar *) name))
+      i = HWPX_TAG_SHAPE;
+    else
+      i = HWPX_TAG_OTHER;
+  }
+
+  g_hash_table_insert (context->tags, (gpointer) name, GUINT_TO_POINTER (i));
+
+  return i;
+}
+
+static guint32 hwpx_attr_uint (int             n_attributes,
+                               const xmlChar **attributes,
+                               const gchar    *name)
+{
+  return _hwp_sax_attr_uint (n_attributes, attributes, name, FALSE);
+}
+
+/* for the guint16 fields of the models; saturated rather than truncated */
+static guint16 hwpx_attr_uint16 (int             n_attributes,
+                                 const xmlChar **attributes,
+                                 const gchar    *name)
+{
+  return _hwp_sax_attr_uint16 (n_attributes, attributes, name, FALSE);
+}
+
+static void hwpx_emit_paragraph (HwpParagraph *paragraph,
+                                 gpointer      user_data,
+                                 GError      **error)
+{
+  HwpHWPXParser          *parser = user_data;
+  HwpListenableInterface *iface;
+
+  iface = HWP_LISTENABLE_GET_IFACE (parser->listenable);
+
+  if (iface->paragraph)
+    iface->paragraph (parser->listenable, paragraph, parser->user_data, error);
+  else
+    g_object_unref (paragraph);
+}
+
+static void hwpx_end_paragraph (HwpxContext *context)
+{
+  HwpParagraph *paragraph = _hwp_sax_end_paragraph (&context->body,
+                                                    context->section_index);
+
+  if (paragraph)
+    context->sink (paragraph, context->sink_data, context->error);
+}
+
+static void hwpx_begin_table (HwpxContext     *context,
+                              int              n_attributes,
+                              const xmlChar  **attributes)
+{
+  HwpSaxTable *t;
+
+  t = _hwp_sax_begin_table (&context->body,
+                            hwpx_attr_uint16 (n_attributes, attributes, "rowCnt"),
+                            hwpx_attr_uint16 (n_attributes, attributes, "colCnt"));
+
+  t->table->cell_spacing   = hwpx_attr_uint16 (n_attributes, attributes, "cellSpacing");
+  t->table->border_fill_id = hwpx_attr_uint16 (n_attributes, attributes, "borderFillIDRef");
+}
+
+static void hwpx_start_element (void           *user_data,
+                                const xmlChar  *localname,
+                                const xmlChar  *prefix,
+                                const xmlChar  *uri,
+                                int             n_namespaces,
+                                const xmlChar **namespaces,
+                                int             n_attributes,
+                                int             n_defaulted,
+                                const xmlChar **attributes)
+{
+  HwpxContext *context = user_data;
+  HwpSaxPara  *para    = _hwp_sax_top_para (&context->body);
+  HwpSaxTable *table   = _hwp_sax_top_table (&context->body);
+  gboolean     layout  = !(context->parser->flags & HWP_PARSE_FLAGS_TEXT_ONLY);
+  HwpxTag      tag;
+
+  /* 요소 사이에서 취소를 확인한다; 오류 뒤에는 더 읽지 않는다 */
+  if (*context->error ||
+      g_cancellable_set_error_if_cancelled (context->parser->cancellable,
+                                            context->error))
+  {
+    context->stopped = TRUE;
+    xmlStopParser (context->ctxt);
+    return;
+  }
+
+  /* 관심 없는 요소의 하위 트리는 객체를 만들지 않고 깊이만 센다 */
+  if (context->skip)
+  {
+    context->skip++;
+    return;
+  }
+
+  tag = hwpx_tag_lookup (context, localname);
+
+  if ((tag == HWPX_TAG_TBL   && !(context->events & HWP_EVENT_TABLES)) ||
+      (tag == HWPX_TAG_NOTE  && !(context->events & HWP_EVENT_NOTES))  ||
+      (tag == HWPX_TAG_SHAPE && !(context->events & HWP_EVENT_SHAPES)))
+  {
+    context->skip = 1;
+    return;
+  }
+
+  switch (tag)
+  {
+    case HWPX_TAG_P:
+      _hwp_sax_begin_paragraph (&context->body, layout);
+      break;
+    case HWPX_TAG_RUN:
+      /* <hp:run> 하나가 글자 모양 구간 하나이다 */
+      if (para)
+        _hwp_sax_add_run (para, hwpx_attr_uint (n_attributes, attributes, "charPrIDRef"));
+      break;
+    case HWPX_TAG_T:
+      if (para)
+        para->in_text++;
+      break;
+    case HWPX_TAG_TAB:
+      if (para && para->in_text)
+        g_string_append_c (para->text, '\t');
+      break;
+    case HWPX_TAG_LINEBREAK:
+      if (para && para->in_text)
+        g_string_append_c (para->text, '\n');
+      break;
+    case HWPX_TAG_SECPR:
+      if (layout && para && !para->paragraph->secd &&
+          (context->events & HWP_EVENT_SECTION_DEFS))
+        hwp_paragraph_set_secd (para->paragraph, hwp_secd_new ());
+      break;
+    case HWPX_TAG_PAGEPR:
+      if (para && para->paragraph->secd)
+      {
+        HwpSecd *secd = para->paragraph->secd;
+        secd->page_width_in_points  = hwpx_attr_uint (n_attributes, attributes, "width") / 7200.0 * 72;
+        secd->page_height_in_points = hwpx_attr_uint (n_attributes, attributes, "height") / 7200.0 * 72;
+        context->in_page_pr = TRUE;
+      }
+      break;
+    case HWPX_TAG_MARGIN:
+      /* <hp:margin> 은 그림 등에도 쓰이므로 pagePr 안의 것만 본다 */
+      if (context->in_page_pr && para && para->paragraph->secd)
+      {
+        HwpSecd *secd = para->paragraph->secd;
+        secd->page_left_margin_in_points   = hwpx_attr_uint (n_attributes, attributes, "left") / 7200.0 * 72;
+        secd->page_right_margin_in_points  = hwpx_attr_uint (n_attributes, attributes, "right") / 7200.0 * 72;
+        secd->page_top_margin_in_points    = hwpx_attr_uint (n_attributes, attributes, "top") / 7200.0 * 72;
+        secd->page_bottom_margin_in_points = hwpx_attr_uint (n_attributes, attributes, "bottom") / 7200.0 * 72;
+        secd->page_header_margin_in_points = hwpx_attr_uint (n_attributes, attributes, "header") / 7200.0 * 72;
+        secd->page_footer_margin_in_points = hwpx_attr_uint (n_attributes, attributes, "footer") / 7200.0 * 72;
+        secd->page_gutter_margin_in_points = hwpx_attr_uint (n_attributes, attributes, "gutter") / 7200.0 * 72;
+      }
+      break;
+    case HWPX_TAG_TBL:
+      hwpx_begin_table (context, n_attributes, attributes);
+      break;
+    case HWPX_TAG_INMARGIN:
+      if (table && !table->cell)
+      {
+        table->table->left_margin   = hwpx_attr_uint16 (n_attributes, attributes, "left");
+        table->table->right_margin  = hwpx_attr_uint16 (n_attributes, attributes, "right");
+        table->table->top_margin    = hwpx_attr_uint16 (n_attributes, attributes, "top");
+        table->table->bottom_margin = hwpx_attr_uint16 (n_attributes, attributes, "bottom");
+      }
+      break;
+    case HWPX_TAG_TC:
+      if (table && !table->cell)
+      {
+        table->cell = hwp_table_cell_new ();
+        table->cell->border_fill_id = hwpx_attr_uint16 (n_attributes, attributes, "borderFillIDRef");
+      }
+      break;
+    case HWPX_TAG_CELLADDR:
+      if (table && table->cell)
+      {
+        table->cell->col_addr = hwpx_attr_uint16 (n_attributes, attributes, "colAddr");
+        table->cell->row_addr = hwpx_attr_uint16 (n_attributes, attributes, "rowAddr");
+      }
+      break;
+    case HWPX_TAG_CELLSPAN:
+      if (table && table->cell)
+      {
+        table->cell->col_span = hwpx_attr_uint16 (n_attributes, attributes, "colSpan");
+        table->cell->row_span = hwpx_attr_uint16 (n_attributes, attributes, "rowSpan");
+      }
+      break;
+    case HWPX_TAG_CELLSZ:
+      if (table && table->cell)
+      {
+        table->cell->width  = hwpx_attr_uint (n_attributes, attributes, "width");
+        table->cell->height = hwpx_attr_uint (n_attributes, attributes, "height");
+      }
+      break;
+    case HWPX_TAG_CELLMARGIN:
+      if (table && table->cell)
+      {
+        table->cell->left_margin   = hwpx_attr_uint16 (n_attributes, attributes, "left");
+        table->cell->right_margin  = hwpx_attr_uint16 (n_attributes, attributes, "right");
+        table->cell->top_margin    = hwpx_attr_uint16 (n_attributes, attributes, "top");
+        table->cell->bottom_margin = hwpx_attr_uint16 (n_attributes, attributes, "bottom");
+      }
+      break;
+    case HWPX_TAG_OTHER:
+    default:
+      break;
+  }
+}
+
+static void hwpx_end_element (void          *user_data,
+                              const xmlChar *localname,
+                              const xmlChar *prefix,
+                              const xmlChar *uri)
+{
+  HwpxContext *context = user_data;
+  HwpSaxPara  *para    = _hwp_sax_top_para (&context->body);
+  HwpSaxTable *table   = _hwp_sax_top_table (&context->body);
+
+  if (context->skip)
+  {
+    context->skip--;
+    return;
+  }
+
+  switch (hwpx_tag_lookup (context, localname))
+  {
+    case HWPX_TAG_P:
+      if (para)
+        hwpx_end_paragraph (context);
+      break;
+    case HWPX_TAG_T:
+      if (para && para->in_text)
+        para->in_text--;
+      break;
+    case HWPX_TAG_PAGEPR:
+      context->in_page_pr = FALSE;
+      break;
+    case HWPX_TAG_TBL:
+      if (table)
+        _hwp_sax_end_table (&context->body);
+      break;
+    case HWPX_TAG_TC:
+      /* a cell ends only where its own paragraphs are closed */
+      if (table && table->cell && table->depth == context->body.paras->len)
+        _hwp_sax_end_cell (table);
+      break;
+    default:
+      break;
+  }
+}
+
+static void hwpx_characters (void *user_data, const xmlChar *ch, int len)
+{
+  HwpxContext *context = user_data;
+  HwpSaxPara  *para    = _hwp_sax_top_para (&context->body);
+
+  /* 글자는 <hp:t> 안에만 있다 */
+  if (para && para->in_text && !context->skip)
+    g_string_append_len (para->text, (const gchar *) ch, len);
+}
+
+static int read_input_stream (void *user_data, char *buffer, int len)
+{
+  HwpxContext *context = user_data;
+
+  return (int) g_input_stream_read (context->stream, buffer, len,
+                                    context->parser->cancellable, NULL);
+}
+
+/* parses the section @index, handing its top level paragraphs to @sink;
+ * @error must not be %NULL */
+static void hwp_hwpx_parser_parse_section (HwpHWPXParser *parser,
+                                           HwpHWPXFile   *file,
+                                           guint          index,
+                                           void         (*sink) (HwpParagraph *,
+                                                                 gpointer,
+                                                                 GError **),
+                                           gpointer       sink_data,
+                                           GError       **error)
+{
+  GInputStream    *stream;
+  xmlSAXHandler    sax;
+  xmlParserCtxtPtr ctxt;
+  HwpxContext      context;
+
+  stream = hwp_hwpx_file_get_section_stream (file, index, error);
+
+  if (!stream)
+    return;
+
+  memset (&sax, 0, sizeof sax);
+  sax.initialized    = XML_SAX2_MAGIC;
+  sax.startElementNs = hwpx_start_element;
+  sax.endElementNs   = hwpx_end_element;
+  sax.characters     = hwpx_characters;
+
+  /* read_input_stream () 는 문서를 만들 때부터 불릴 수 있다 */
+  context.parser = parser;
+  context.stream = stream;
+
+  ctxt = xmlCreateIOParserCtxt (&sax, &context, read_input_stream, NULL,
+                                &context, XML_CHAR_ENCODING_NONE);
+  if (ctxt == NULL)
+  {
+    g_warning ("%s:%d: unable to open section %u\n", __FILE__, __LINE__, index);
+    g_object_unref (stream);
+    return;
+  }
+
+  /* 외부 엔티티와 네트워크는 쓰지 않는다 */
+  xmlCtxtUseOptions (ctxt, XML_PARSE_NONET | XML_PARSE_NOWARNING);
+
+  context.ctxt          = ctxt;
+  context.error         = error;
+  context.section_index = index;
+  context.sink          = sink;
+  context.sink_data     = sink_data;
+  context.tags          = g_hash_table_new (g_direct_hash, g_direct_equal);
+  _hwp_sax_body_init (&context.body);
+  context.in_page_pr    = FALSE;
+  context.events        = parser->events;
+  context.skip          = 0;
+  context.stopped       = FALSE;
+
+  xmlParseDocument (ctxt);
+
+  /* 읽는 도중에 취소되었으면 libxml2 는 읽기 오류로만 안다 */
+  if (!*error)
+    g_cancellable_set_error_if_cancelled (parser->cancellable, error);
+
+  if (!ctxt->wellFormed && !context.stopped && !*error)
+    g_warning ("%s:%d: failed to parse section %u\n", __FILE__, __LINE__, index);
+
+  _hwp_sax_body_clear (&context.body);
+  g_hash_table_destroy (context.tags);
+  xmlFreeParserCtxt (ctxt);
+  g_object_unref (stream);
+}
+
+typedef struct
+{
+  guint      index;
+  GPtrArray *paragraphs;
+  GError    *error;
+} JobResult;
+
+typedef struct
+{
+  HwpHWPXParser *parser;
+  HwpHWPXFile   *file;
+  GAsyncQueue   *results;
+  gint           cancelled;
+} ParseJobs;
+
+static JobResult *job_result_new (guint index)
+{
+  JobResult *result  = g_slice_new0 (JobResult);
+  result->index      = index;
+  result->paragraphs = g_ptr_array_new ();
+
+  return result;
+}
+
+static void job_result_free (JobResult *result)
+{
+  for (guint i = 0; i < result->paragraphs->len; i++)
+    if (g_ptr_array_index (result->paragraphs, i))
+      g_object_unref (g_ptr_array_index (result->paragraphs, i));
+
+  g_ptr_array_unref (result->paragraphs);
+  g_clear_error (&result->error);
+  g_slice_free (JobResult, result);
+}
+
+static void collect_paragraph (HwpParagraph *paragraph,
+                               gpointer      paragraphs,
+                               GError      **error)
+{
+  g_ptr_array_add (paragraphs, paragraph);
+}
+
+/* runs on a pool thread; the index is pushed off by one since a
+ * GThreadPool can't take NULL */
+static void parse_section_job (gpointer data, gpointer user_data)
+{
+  ParseJobs *jobs   = user_data;
+  JobResult *result = job_result_new (GPOINTER_TO_UINT (data) - 1);
+
+  if (!g_atomic_int_get (&jobs->cancelled) &&
+      !g_cancellable_set_error_if_cancelled (jobs->parser->cancellable,
+                                             &result->error))
+    hwp_hwpx_parser_parse_section (jobs->parser, jobs->file, result->index,
+                                   collect_paragraph, result->paragraphs,
+                                   &result->error);
+
+  g_async_queue_push (jobs->results, result);
+}
+
+/* hands the paragraphs of @result to the listener on the calling thread */
+static void deliver_job_result (HwpHWPXParser *parser,
+                                JobResult     *result,
+                                GError       **error)
+{
+  if (result->error)
+  {
+    g_propagate_error (error, result->error);
+    result->error = NULL;
+    return;
+  }
+
+  for (guint i = 0; i < result->paragraphs->len && !*error; i++)
+  {
+    HwpParagraph *paragraph = g_ptr_array_index (result->paragraphs, i);
+    g_ptr_array_index (result->paragraphs, i) = NULL;
+    hwpx_emit_paragraph (paragraph, parser, error);
+  }
+}
+
+/* waits for @n_jobs results and delivers them, in section order unless
+ * HWP_PARSE_FLAGS_UNORDERED is set; after an error the remaining jobs
+ * are cancelled and their results dropped */
+static void receive_job_results (HwpHWPXParser *parser,
+                                 ParseJobs     *jobs,
+                                 guint          n_jobs,
+                                 GError       **error)
+{
+  JobResult **pending   = g_new0 (JobResult *, n_jobs);
+  gboolean    unordered = parser->flags & HWP_PARSE_FLAGS_UNORDERED;
+  guint       next      = 0;
+
+  for (guint received = 0; received < n_jobs; received++)
+  {
+    JobResult *result = g_async_queue_pop (jobs->results);
+
+    if (*error)
+    {
+      job_result_free (result);
+      continue;
+    }
+
+    if (unordered)
+    {
+      deliver_job_result (parser, result, error);
+      job_result_free (result);
+    }
+    else
+    {
+      /* 앞의 구역이 모두 끝날 때까지 보관한다 */
+      pending[result->index] = result;
+
+      while (next < n_jobs && pending[next] && !*error)
+      {
+        deliver_job_result (parser, pending[next], error);
+        job_result_free (pending[next]);
+        pending[next++] = NULL;
+      }
+    }
+
+    if (*error)
+      g_atomic_int_set (&jobs->cancelled, 1);
+  }
+
+  for (guint i = 0; i < n_jobs; i++)
+    if (pending[i])
+      job_result_free (pending[i]);
+
+  g_free (pending);
+}
+
+static void hwp_hwpx_parser_parse_sections_parallel (HwpHWPXParser *parser,
+                                                     HwpHWPXFile   *file,
+                                                     GError       **error)
+{
+  guint        n_sections = hwp_hwpx_file_get_n_sections (file);
+  ParseJobs    jobs       = { parser, file, NULL, 0 };
+  GThreadPool *pool;
+
+  if (n_sections == 0)
+    return;
+
+  jobs.results = g_async_queue_new ();
+  pool = g_thread_pool_new (parse_section_job, &jobs,
+                            MIN (g_get_num_processors (), n_sections),
+                            FALSE, error);
+  if (!pool)
+  {
+    g_async_queue_unref (jobs.results);
+    return;
+  }
+
+  for (guint i = 0; i < n_sections; i++)
+    g_thread_pool_push (pool, GUINT_TO_POINTER (i + 1), NULL);
+
+  receive_job_results (parser, &jobs, n_sections, error);
+
+  g_thread_pool_free (pool, FALSE, TRUE);
+  g_async_queue_unref (jobs.results);
+}
+
+typedef struct {
+  HwpSummaryInfo *info;
+  gchar         **field;
+  GString        *buffer;
+} HpfContext;
+
+static void hpf_start_element (void           *user_data,
+                               const xmlChar  *localname,
+                               const xmlChar  *prefix,
+                               const xmlChar  *uri,
+                               int             n_namespaces,
+                               const xmlChar **namespaces,
+                               int             n_attributes,
+                               int             n_defaulted,
+                               const xmlChar **attributes)
+{
+  HpfContext *context = user_data;
+
+  if (strcmp ((const gchar *) localname, "title") == 0)
+  {
+    context->field = &context->info->title;
+  }
+  else if (strcmp ((const gchar *) localname, "meta") == 0)
+  {
+    /* <opf:meta name="creator" content="text">...</opf:meta> */
+    for (int i = 0; i < n_attributes; i++)
+    {
+      const xmlChar **attr = attributes + i * 5;
+      gsize           len  = attr[4] - attr[3];
+      const gchar    *name = (const gchar *) attr[3];
+
+      if (strcmp ((const gchar *) attr[0], "name") != 0)
+        continue;
+
+      if (len == 7 && strncmp (name, "creator", len) == 0)
+        context->field = &context->info->creator;
+      else if (len == 7 && strncmp (name, "subject", len) == 0)
+        context->field = &context->info->subject;
+      else if (len == 11 && strncmp (name, "description", len) == 0)
+        context->field = &context->info->desc;
+      else if (len == 7 && strncmp (name, "keyword", len) == 0)
+        context->field = &context->info->keywords;
+      else if (len == 10 && strncmp (name, "lastsaveby", len) == 0)
+        context->field = &context->info->last_saved_by;
+    }
+  }
+
+  g_string_truncate (context->buffer, 0);
+}
+
+static void hpf_end_element (void          *user_data,
+                             const xmlChar *localname,
+                             const xmlChar *prefix,
+                             const xmlChar *uri)
+{
+  HpfContext *context = user_data;
+
+  if (context->field)
+  {
+    g_free (*context->field);
+    *context->field = g_strndup (context->buffer->str, context->buffer->len);
+    context->field = NULL;
+  }
+}
+
+static void hpf_characters (void *user_data, const xmlChar *ch, int len)
+{
+  HpfContext *context = user_data;
+
+  if (context->field)
+    g_string_append_len (context->buffer, (const gchar *) ch, len);
+}
+
+/* the summary is the OPF metadata of Contents/content.hpf */
+static void hwp_hwpx_parser_parse_summary_info (HwpHWPXParser *parser,
+                                                HwpHWPXFile   *file,
+                                                GError       **error)
+{
+  HwpListenableInterface *iface;
+  GBytes                 *bytes;
+  gsize                   size;
+  xmlSAXHandler           sax;
+  xmlParserCtxtPtr        ctxt;
+  HwpSaxMemory            memory;
+  HpfContext              context;
+
+  iface = HWP_LISTENABLE_GET_IFACE (parser->listenable);
+
+  if (!(parser->events & HWP_EVENT_SUMMARY_INFO))
+    return;
+
+  bytes = _hwp_hwpx_file_get_entry_bytes (file, "Contents/content.hpf", error);
+
+  if (!bytes)
+    return;
+
+  memset (&sax, 0, sizeof sax);
+  sax.initialized    = XML_SAX2_MAGIC;
+  sax.startElementNs = hpf_start_element;
+  sax.endElementNs   = hpf_end_element;
+  sax.characters     = hpf_characters;
+
+  g_clear_object (&parser->priv->info);
+  parser->priv->info = hwp_summary_info_new ();
+
+  context.info   = parser->priv->info;
+  context.field  = NULL;
+  context.buffer = g_string_new (NULL);
+
+  memory.pos = g_bytes_get_data (bytes, &size);
+  memory.end = memory.pos + size;
+
+  ctxt = xmlCreateIOParserCtxt (&sax, &context, _hwp_sax_read_memory, NULL,
+                                &memory, XML_CHAR_ENCODING_NONE);
+  if (ctxt)
+  {
+    /* 외부 엔티티와 네트워크는 쓰지 않는다 */
+    xmlCtxtUseOptions (ctxt, XML_PARSE_NONET | XML_PARSE_NOWARNING);
+    xmlParseDocument (ctxt);
+
+    if (!ctxt->wellFormed)
+      g_warning ("%s:%d: failed to parse content.hpf\n", __FILE__, __LINE__);
+
+    xmlFreeParserCtxt (ctxt);
+  }
+  else
+  {
+    g_warning ("%s:%d: unable to open content.hpf\n", __FILE__, __LINE__);
+  }
+
+  g_string_free (context.buffer, TRUE);
+  g_bytes_unref (bytes);
+
+  iface->summary_info (parser->listenable,
+                       g_object_ref (parser->priv->info),
+                       parser->user_data,
+                       error);
+}
+
+static void hwp_hwpx_parser_parse_prv_text (HwpHWPXParser *parser,
+                                            HwpHWPXFile   *file,
+                                            GError       **error)
+{
+  HwpListenableInterface *iface;
+  GBytes                 *bytes;
+  const gchar            *data;
+  gsize                   size;
+
+  iface = HWP_LISTENABLE_GET_IFACE (parser->listenable);
+
+  if (!(parser->events & HWP_EVENT_PRV_TEXT))
+    return;
+
+  bytes = _hwp_hwpx_file_get_entry_bytes (file, "Preview/PrvText.txt", error);
+
+  if (!bytes)
+    return;
+
+  /* HWPX 의 미리보기 텍스트는 UTF-8 이다 */
+  data = g_bytes_get_data (bytes, &size);
+
+  if (g_utf8_validate (data, size, NULL))
+    iface->prv_text (parser->listenable,
+                     g_strndup (data, size),
+                     parser->user_data,
+                     error);
+  else
+    g_warning ("%s:%d: invalid preview text\n", __FILE__, __LINE__);
+
+  g_bytes_unref (bytes);
+}
+
+/* @error must not be %NULL */
+static void hwpx_parser_parse (HwpHWPXParser *parser,
+                               HwpHWPXFile   *file,
+                               GError       **error)
+{
+  HwpListenableInterface *iface;
+  iface = HWP_LISTENABLE_GET_IFACE (parser->listenable);
+
+  parser->events = hwp_listenable_get_event_mask (parser->listenable);
+
+  if (iface->document_version)
+    iface->document_version (parser->listenable,
+                             file->major_version,
+                             file->minor_version,
+                             file->micro_version,
+                             file->extra_version,
+                             parser->user_data,
+                             error);
+
+  hwp_hwpx_parser_parse_summary_info (parser, file, error);
+  if (*error)
+    return;
+
+  hwp_hwpx_parser_parse_prv_text (parser, file, error);
+  if (*error)
+    return;
+
+  if ((parser->flags & HWP_PARSE_FLAGS_METADATA_ONLY) ||
+      !(parser->events & HWP_EVENT_PARAGRAPHS))
+    return;
+
+  if (parser->flags & HWP_PARSE_FLAGS_PARALLEL_SECTIONS)
+  {
+    hwp_hwpx_parser_parse_sections_parallel (parser, file, error);
+    return;
+  }
+
+  for (guint i = 0; i < hwp_hwpx_file_get_n_sections (file) && !*error; i++)
+    hwp_hwpx_parser_parse_section (parser, file, i, hwpx_emit_paragraph,
+                                   parser, error);
+}
+
+/**
+ * hwp_hwpx_parser_parse:
+ * @parser: a #HwpHWPXParser
+ * @file: a #HwpHWPXFile
+ * @error: a #GError
+ *
+ * Parses @file and reports it to the #HwpListenable of @parser.  The
+ * sections are parsed on a thread pool with
+ * %HWP_PARSE_FLAGS_PARALLEL_SECTIONS.
+ *
+ * Since: 2016.06.01
+ */
+void hwp_hwpx_parser_parse (HwpHWPXParser *parser,
+                            HwpHWPXFile   *file,
+                            GError       **error)
+{
+  g_return_if_fail (HWP_IS_HWPX_PARSER (parser));
+  g_return_if_fail (HWP_IS_HWPX_FILE (file));
+
+  GError *tmp_error = NULL;
+
+  hwpx_parser_parse (parser, file, &tmp_error);
+
+  if (tmp_error)
+    g_propagate_error (error, tmp_error);
+}
+
+static void hwp_hwpx_parser_finalize (GObject *object)
+{
+  HwpHWPXParser *parser = HWP_HWPX_PARSER (object);
+
+  if (parser->priv->info)
+    g_object_unref (parser->priv->info);
+
+  G_OBJECT_CLASS (hwp_hwpx_parser_parent_class)->finalize (object);
+}
+
+static void hwp_hwpx_parser_class_init (HwpHWPXParserClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  g_type_class_add_private (klass, sizeof (HwpHWPXParserPrivate));
+  object_class->finalize = hwp_hwpx_parser_finalize;
+  /* libxml2 must be initialized once before sections are parsed on
+   * other threads; class_init is run exactly once, under the GType lock */
+  xmlInitParser ();
+}
+
+static void hwp_hwpx_parser_init (HwpHWPXParser *parser)
+{
+  parser->priv = G_TYPE_INSTANCE_GET_PRIVATE (parser,
+                                              HWP_TYPE_HWPX_PARSER,
+                                              HwpHWPXParserPrivate);
+  parser->events = HWP_EVENT_ALL;
+}
+
+/**
+ * hwp_hwpx_parser_new:
+ * @listenable: a #HwpListenable
+ * @user_data: a #gpointer
+ *
+ * Returns: a new #HwpHWPXParser
+ *
+ * Since: 2016.06.01
+ */
+HwpHWPXParser *hwp_hwpx_parser_new (HwpListenable *listenable,
+                                    gpointer       user_data)
+{
+  g_return_val_if_fail (HWP_IS_LISTENABLE (listenable), NULL);
+
+  HwpHWPXParser *parser = g_object_new (HWP_TYPE_HWPX_PARSER, NULL);
+  parser->listenable    = listenable;
+  parser->user_data     = user_data;
+
+  return parser;
+}
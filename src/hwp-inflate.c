@@ -0,0 +1,296 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/*
+ * hwp-inflate.c
+ * This file is part of the libhwp project.
+ *
+ * Copyright (C) 2016 Hodong Kim <cogniti@gmail.com>
+ *
+ * The libhwp is dual licensed under the LGPL v3+ or Apache License 2.0
+ *
+ * The libhwp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The libhwp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program;  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Or,
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Whole-buffer raw deflate decoding.  HWP5 compresses every stream with
+ * raw deflate (no zlib or gzip header); once the compressed stream is in
+ * memory it can be inflated in one call into a single output buffer,
+ * without the GConverter machinery and its small intermediate buffers.
+ *
+ * The output never grows past @max_len, or HWP_INFLATE_OUTPUT_MAX if it
+ * is 0; a stream that inflates to more than that fails with
+ * HWP_ERROR_INVALID, and callers that can fall back to incremental
+ * inflating do so.
+ *
+ * The decoder state is kept per thread and reused.  libdeflate is used
+ * when configure found it, zlib otherwise (zlib-ng in compat mode is
+ * picked up as zlib).
+ */
+
+#include "config.h"
+
+#include <glib/gi18n-lib.h>
+#include <gio/gio.h>
+
+#ifdef HAVE_LIBDEFLATE
+#include <libdeflate.h>
+#else
+#include <zlib.h>
+#endif
+
+#include "hwp-enums.h"
+#include "hwp-inflate.h"
+
+static guint8 *alloc_output (gsize  len,
+                             gsize  size_hint,
+                             gsize  max_len,
+                             gsize *capacity)
+{
+  if (size_hint)
+    *capacity = size_hint;
+  else if (len > max_len / 4)
+    *capacity = max_len;
+  else
+    *capacity = MAX (len * 4, 4096);
+
+  *capacity = MIN (*capacity, max_len);
+
+  return g_try_malloc (*capacity);
+}
+
+/* 출력 버퍼를 두 배로 늘린다; 상한에 닿았거나 할당에 실패하면 @out 을
+ * 해제하고 NULL 을 돌려준다 */
+static guint8 *grow_output (guint8 *out, gsize *capacity, gsize max_len)
+{
+  guint8 *grown;
+
+  if (*capacity >= max_len)
+  {
+    g_free (out);
+    return NULL;
+  }
+
+  *capacity = MIN (*capacity * 2, max_len);
+
+  if (!(grown = g_try_realloc (out, *capacity)))
+    g_free (out);
+
+  return grown;
+}
+
+static void set_too_large_error (GError **error)
+{
+  g_set_error_literal (error, HWP_ERROR, HWP_ERROR_INVALID,
+                       _("Decompressed data is too large"));
+}
+
+#ifdef HAVE_LIBDEFLATE
+
+static void free_decompressor (gpointer decompressor)
+{
+  libdeflate_free_decompressor (decompressor);
+}
+
+static GPrivate decompressor_key = G_PRIVATE_INIT (free_decompressor);
+
+GBytes *_hwp_inflate_raw (const guint8 *data,
+                          gsize         len,
+                          gsize         size_hint,
+                          gsize         max_len,
+                          GError      **error)
+{
+  struct libdeflate_decompressor *decompressor;
+  enum libdeflate_result          result;
+  gsize                           capacity;
+  gsize                           in_len;
+  gsize                           out_len;
+  guint8                         *out;
+
+  decompressor = g_private_get (&decompressor_key);
+  if (!decompressor)
+  {
+    decompressor = libdeflate_alloc_decompressor ();
+    g_private_set (&decompressor_key, decompressor);
+  }
+
+  if (max_len == 0)
+    max_len = HWP_INFLATE_OUTPUT_MAX;
+
+  if (!(out = alloc_output (len, size_hint, max_len, &capacity)))
+  {
+    set_too_large_error (error);
+    return NULL;
+  }
+
+  /* libdeflate needs room for the whole output; grow and retry */
+  while ((result = libdeflate_deflate_decompress_ex (decompressor,
+                                                     data, len,
+                                                     out, capacity,
+                                                     &in_len, &out_len))
+         == LIBDEFLATE_INSUFFICIENT_SPACE)
+  {
+    if (!(out = grow_output (out, &capacity, max_len)))
+    {
+      set_too_large_error (error);
+      return NULL;
+    }
+  }
+
+  if (result != LIBDEFLATE_SUCCESS)
+  {
+    g_free (out);
+    g_set_error_literal (error, HWP_ERROR, HWP_ERROR_INVALID,
+                         _("File corrupted"));
+    return NULL;
+  }
+
+  return g_bytes_new_take (g_realloc (out, out_len), out_len);
+}
+
+#else /* !HAVE_LIBDEFLATE */
+
+static void free_z_stream (gpointer strm)
+{
+  inflateEnd (strm);
+  g_free (strm);
+}
+
+static GPrivate z_stream_key = G_PRIVATE_INIT (free_z_stream);
+
+GBytes *_hwp_inflate_raw (const guint8 *data,
+                          gsize         len,
+                          gsize         size_hint,
+                          gsize         max_len,
+                          GError      **error)
+{
+  z_stream *strm = g_private_get (&z_stream_key);
+  gsize     capacity;
+  gsize     out_len = 0;
+  guint8   *out;
+  int       ret;
+
+  if (!strm)
+  {
+    strm = g_new0 (z_stream, 1);
+    if (inflateInit2 (strm, -MAX_WBITS) != Z_OK)
+    {
+      g_free (strm);
+      g_set_error_literal (error, HWP_ERROR, HWP_ERROR_INVALID,
+                           _("Cannot initialize the decompressor"));
+      return NULL;
+    }
+    g_private_set (&z_stream_key, strm);
+  }
+  else
+  {
+    inflateReset (strm);
+  }
+
+  if (max_len == 0)
+    max_len = HWP_INFLATE_OUTPUT_MAX;
+
+  if (!(out = alloc_output (len, size_hint, max_len, &capacity)))
+  {
+    set_too_large_error (error);
+    return NULL;
+  }
+
+  strm->next_in  = (Bytef *) data;
+  strm->avail_in = 0;
+
+  do
+  {
+    if (out_len == capacity && !(out = grow_output (out, &capacity, max_len)))
+    {
+      set_too_large_error (error);
+      return NULL;
+    }
+
+    /* avail_in/avail_out are uInt; feed very large buffers in pieces */
+    if (strm->avail_in == 0)
+      strm->avail_in = (uInt) MIN (len - ((const guint8 *) strm->next_in - data),
+                                   G_MAXUINT32);
+
+    strm->next_out  = out + out_len;
+    strm->avail_out = (uInt) MIN (capacity - out_len, G_MAXUINT32);
+
+    ret = inflate (strm, Z_NO_FLUSH);
+    out_len = strm->next_out - out;
+  } while (ret == Z_OK ||
+           (ret == Z_BUF_ERROR && strm->avail_out == 0));
+
+  if (ret != Z_STREAM_END)
+  {
+    g_free (out);
+    g_set_error_literal (error, HWP_ERROR, HWP_ERROR_INVALID,
+                         _("File corrupted"));
+    return NULL;
+  }
+
+  return g_bytes_new_take (g_realloc (out, out_len), out_len);
+}
+
+#endif /* HAVE_LIBDEFLATE */
+
+/*
+ * For a stream that _hwp_inflate_raw() rejected: inflates @data
+ * incrementally and returns what could be decoded before the corruption,
+ * still bounded by HWP_INFLATE_OUTPUT_MAX, so that a parser can report
+ * the part of the document in front of it.
+ */
+GBytes *_hwp_inflate_raw_partial (const guint8 *data, gsize len)
+{
+  GConverter      *zd;
+  GByteArray      *array = g_byte_array_new ();
+  GConverterResult result;
+  gsize            bytes_read;
+  gsize            bytes_written;
+
+  zd = G_CONVERTER (g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW));
+
+  do
+  {
+    guint out_len = array->len;
+
+    g_byte_array_set_size (array, out_len + 64 * 1024);
+    result = g_converter_convert (zd, data, len,
+                                  array->data + out_len, 64 * 1024,
+                                  G_CONVERTER_INPUT_AT_END,
+                                  &bytes_read, &bytes_written, NULL);
+    if (result == G_CONVERTER_ERROR)
+      bytes_written = 0;
+
+    g_byte_array_set_size (array, out_len + bytes_written);
+    data += bytes_read;
+    len  -= bytes_read;
+  } while (result == G_CONVERTER_CONVERTED &&
+           array->len < HWP_INFLATE_OUTPUT_MAX);
+
+  g_object_unref (zd);
+
+  return g_byte_array_free_to_bytes (array);
+}
@@ -0,0 +1,61 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/*
+ * hwp-inflate.h
+ * This file is part of the libhwp project.
+ *
+ * Copyright (C) 2016 Hodong Kim <cogniti@gmail.com>
+ *
+ * The libhwp is dual licensed under the LGPL v3+ or Apache License 2.0
+ *
+ * The libhwp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The libhwp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program;  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Or,
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HWP_INFLATE_H__
+#define __HWP_INFLATE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* compressed streams larger than this are inflated incrementally */
+#define HWP_INFLATE_WHOLE_MAX (64 * 1024 * 1024)
+/* _hwp_inflate_raw() fails rather than produce more than this, unless
+ * the caller passes a smaller max_len */
+#define HWP_INFLATE_OUTPUT_MAX (512 * 1024 * 1024)
+
+GBytes *_hwp_inflate_raw         (const guint8 *data,
+                                  gsize         len,
+                                  gsize         size_hint,
+                                  gsize         max_len,
+                                  GError      **error);
+GBytes *_hwp_inflate_raw_partial (const guint8 *data,
+                                  gsize         len);
+
+G_END_DECLS
+
+#endif /* __HWP_INFLATE_H__ */
@@ -42,3 +42,47 @@ G_DEFINE_INTERFACE (HwpListenable, hwp_listenable, G_TYPE_OBJECT)
 static void hwp_listenable_default_init (HwpListenableInterface *iface)
 {
 }
+
+/**
+ * hwp_listenable_get_event_mask:
+ * @listenable: a #HwpListenable
+ *
+ * Returns the events @listenable consumes: those it declares with
+ * #HwpListenableInterface.get_event_mask, less the ones whose callbacks
+ * it does not implement.  A listener without a paragraph callback
+ * consumes nothing of the document body.
+ *
+ * Returns: a #HwpEventMask
+ *
+ * Since: 2016.06.01
+ */
+HwpEventMask hwp_listenable_get_event_mask (HwpListenable *listenable)
+{
+  g_return_val_if_fail (HWP_IS_LISTENABLE (listenable), HWP_EVENT_NONE);
+
+  HwpListenableInterface *iface = HWP_LISTENABLE_GET_IFACE (listenable);
+  HwpEventMask            mask  = HWP_EVENT_ALL;
+
+  if (iface->get_event_mask)
+    mask = iface->get_event_mask (listenable);
+
+  if (!iface->document_version)
+    mask &= ~HWP_EVENT_DOCUMENT_VERSION;
+
+  if (!iface->face_name && !iface->char_shape &&
+      !iface->para_shape && !iface->bin_data)
+    mask &= ~HWP_EVENT_DOC_INFO;
+
+  /* 표, 구역 정의 등은 문단에 붙어서만 전달된다 */
+  if (!iface->paragraph || !(mask & HWP_EVENT_PARAGRAPHS))
+    mask &= ~(HWP_EVENT_PARAGRAPHS | HWP_EVENT_TABLES |
+              HWP_EVENT_SECTION_DEFS | HWP_EVENT_NOTES | HWP_EVENT_SHAPES);
+
+  if (!iface->prv_text)
+    mask &= ~HWP_EVENT_PRV_TEXT;
+
+  if (!iface->summary_info)
+    mask &= ~HWP_EVENT_SUMMARY_INFO;
+
+  return mask;
+}
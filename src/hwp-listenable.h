@@ -69,6 +69,42 @@ G_BEGIN_DECLS
 typedef struct _HwpListenable          HwpListenable; /* dummy typedef */
 typedef struct _HwpListenableInterface HwpListenableInterface;
 
+/**
+ * HwpEventMask:
+ * @HWP_EVENT_NONE: no events
+ * @HWP_EVENT_DOCUMENT_VERSION: the document version
+ * @HWP_EVENT_DOC_INFO: face names, character and paragraph shapes and
+ *   BinData of the DocInfo stream
+ * @HWP_EVENT_PARAGRAPHS: the paragraphs of the document body; tables,
+ *   section definitions, notes and shapes are reported only inside them
+ * @HWP_EVENT_TABLES: tables, as #HwpParagraph.table
+ * @HWP_EVENT_SECTION_DEFS: section definitions, as #HwpParagraph.secd
+ * @HWP_EVENT_NOTES: headers, footers, footnotes and hidden comments
+ * @HWP_EVENT_SHAPES: drawing objects
+ * @HWP_EVENT_PRV_TEXT: the preview text
+ * @HWP_EVENT_SUMMARY_INFO: the summary information
+ * @HWP_EVENT_ALL: all of the above
+ *
+ * The kinds of events a listener consumes.  Record subtrees of kinds that
+ * are not wanted are skipped by the parser without being decoded.
+ *
+ * Since: 2016.06.01
+ */
+typedef enum /*< flags >*/
+{
+  HWP_EVENT_NONE             = 0,
+  HWP_EVENT_DOCUMENT_VERSION = 1 << 0,
+  HWP_EVENT_DOC_INFO         = 1 << 1,
+  HWP_EVENT_PARAGRAPHS       = 1 << 2,
+  HWP_EVENT_TABLES           = 1 << 3,
+  HWP_EVENT_SECTION_DEFS     = 1 << 4,
+  HWP_EVENT_NOTES            = 1 << 5,
+  HWP_EVENT_SHAPES           = 1 << 6,
+  HWP_EVENT_PRV_TEXT         = 1 << 7,
+  HWP_EVENT_SUMMARY_INFO     = 1 << 8,
+  HWP_EVENT_ALL              = (1 << 9) - 1
+} HwpEventMask;
+
 /**
  * HwpListenableInterface:
  * @base_iface: base interface
@@ -80,6 +116,8 @@ typedef struct _HwpListenableInterface HwpListenableInterface;
  * @paragraph: Callback to invoke when #HwpParagraph instance has been built
  * @prv_text: Callback to invoke for prv text
  * @summary_info: Callback to invoke for #HwpSummaryInfo
+ * @get_event_mask: Returns the #HwpEventMask of the events the listener
+ *   consumes; if not implemented, all of them.  Since: 2016.06.01
  */
 struct _HwpListenableInterface
 {
@@ -124,9 +162,12 @@ struct _HwpListenableInterface
                              HwpSummaryInfo *info,
                              gpointer        user_data,
                              GError        **error);
+  /* interest */
+  HwpEventMask (* get_event_mask) (HwpListenable *listenable);
 };
 
-GType hwp_listenable_get_type  (void) G_GNUC_CONST;
+GType        hwp_listenable_get_type       (void) G_GNUC_CONST;
+HwpEventMask hwp_listenable_get_event_mask (HwpListenable *listenable);
 
 G_END_DECLS
 
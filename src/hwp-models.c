@@ -127,6 +127,9 @@ static void hwp_paragraph_finalize (GObject *object)
   if (paragraph->m_id)
     g_free (paragraph->m_id);
 
+  if (paragraph->m_offset)
+    g_free (paragraph->m_offset);
+
   if (paragraph->text_attrs)
     g_ptr_array_free (paragraph->text_attrs, TRUE);
 
@@ -184,6 +187,46 @@ const char *hwp_paragraph_get_text (HwpParagraph *paragraph)
   return paragraph->text;
 }
 
+/**
+ * hwp_paragraph_get_text_attrs:
+ * @paragraph: a #HwpParagraph
+ *
+ * Returns the character shape runs of the paragraph text.  The
+ * start_index and end_index of each #HwpTextAttributes are byte offsets
+ * into the text returned by hwp_paragraph_get_text().
+ *
+ * The parsers record the runs only as #HwpParagraph.m_offset.
+ * #HwpParagraph.text_attrs is %NULL until this function builds it from
+ * them, the first time it is asked for; read it through this function
+ * rather than directly.
+ *
+ * Return value: (transfer none) (element-type HwpTextAttributes) (nullable):
+ *   the text attributes of the paragraph, or %NULL if it has no runs
+ *
+ * Since: 2016.06.01
+ */
+GPtrArray *hwp_paragraph_get_text_attrs (HwpParagraph *paragraph)
+{
+  g_return_val_if_fail (HWP_IS_PARAGRAPH (paragraph), NULL);
+
+  if (paragraph->text_attrs || !paragraph->m_offset)
+    return paragraph->text_attrs;
+
+  paragraph->text_attrs = g_ptr_array_new_full (paragraph->m_len,
+                            (GDestroyNotify) hwp_text_attributes_free);
+
+  for (guint i = 0; i < paragraph->m_len; i++)
+  {
+    HwpTextAttributes *text_attrs = hwp_text_attributes_new ();
+    text_attrs->start_index = paragraph->m_offset[i];
+    /* The character at end_index is not included */
+    text_attrs->end_index   = paragraph->m_offset[i + 1];
+    g_ptr_array_add (paragraph->text_attrs, text_attrs);
+  }
+
+  return paragraph->text_attrs;
+}
+
 /**
  * hwp_paragraph_set_secd:
  * @paragraph: a #HwpParagraph
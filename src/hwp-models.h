@@ -149,7 +149,10 @@ struct _HwpParagraph
   guint32   *m_pos;
   guint32   *m_id;
   guint16    m_len;
-  GPtrArray *text_attrs;
+  GPtrArray *text_attrs; /* filled by hwp_paragraph_get_text_attrs () */
+
+  guint32   *m_offset; /* m_len + 1 byte offsets of the runs in text */
+  guint      section_index;
 };
 
 /**
@@ -163,16 +166,17 @@ struct _HwpParagraphClass
   GObjectClass parent_class;
 };
 
-GType         hwp_paragraph_get_type   (void) G_GNUC_CONST;
-HwpParagraph *hwp_paragraph_new        (void);
-void          hwp_paragraph_set_text   (HwpParagraph *paragraph,
-                                        const gchar  *text);
-const char   *hwp_paragraph_get_text   (HwpParagraph *paragraph);
-HwpTable     *hwp_paragraph_get_table  (HwpParagraph *paragraph);
-void          hwp_paragraph_set_table  (HwpParagraph *paragraph,
-                                        HwpTable     *table);
-void          hwp_paragraph_set_secd   (HwpParagraph *paragraph,
-                                        HwpSecd      *secd);
+GType         hwp_paragraph_get_type       (void) G_GNUC_CONST;
+HwpParagraph *hwp_paragraph_new            (void);
+void          hwp_paragraph_set_text       (HwpParagraph *paragraph,
+                                            const gchar  *text);
+const char   *hwp_paragraph_get_text       (HwpParagraph *paragraph);
+GPtrArray    *hwp_paragraph_get_text_attrs (HwpParagraph *paragraph);
+HwpTable     *hwp_paragraph_get_table      (HwpParagraph *paragraph);
+void          hwp_paragraph_set_table      (HwpParagraph *paragraph,
+                                            HwpTable     *table);
+void          hwp_paragraph_set_secd       (HwpParagraph *paragraph,
+                                            HwpSecd      *secd);
 
 /* HwpTable ****************************************************************/
 
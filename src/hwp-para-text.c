@@ -0,0 +1,374 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/*
+ * hwp-para-text.c
+ * This file is part of the libhwp project.
+ *
+ * Copyright (C) 2016 Hodong Kim <cogniti@gmail.com>
+ *
+ * The libhwp is dual licensed under the LGPL v3+ or Apache License 2.0
+ *
+ * The libhwp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The libhwp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program;  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Or,
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * HWP_TAG_PARA_TEXT decoding: UTF-16LE code units to UTF-8.
+ *
+ * Almost all of a paragraph is ordinary BMP text (ASCII and Hangul
+ * syllables), which is converted in bulk, eight or sixteen code units at a
+ * time when the CPU supports SSE2 or AVX2.  The bulk loop stops at the
+ * first control character (0-31), HyPUA code point or surrogate, which are
+ * handled one at a time.  The SIMD code is chosen at run time; any other
+ * CPU uses the scalar loop.
+ */
+
+#include <string.h>
+#include <gsf/gsf-utils.h>
+
+#include "hwp-charset.h"
+#include "hwp-para-text.h"
+
+#if (defined (__x86_64__) || defined (__i386__)) && \
+    (defined (__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define HWP_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+#define HYPUA_FIRST 0xe0bc
+#define HYPUA_LAST  0xf8f7
+
+/* 일반 문자: 제어 문자, 서로게이트, 한양PUA 가 아닌 BMP 문자 */
+static inline gboolean is_special (guint16 c)
+{
+  return c < 0x20 ||
+         (c >= 0xd800 && c <= 0xdfff) ||
+         (c >= HYPUA_FIRST && c <= HYPUA_LAST);
+}
+
+static inline guint8 *put_utf8 (guint8 *out, guint16 c)
+{
+  if (c < 0x80)
+  {
+    *out++ = c;
+  }
+  else if (c < 0x800)
+  {
+    *out++ = 0xc0 | (c >> 6);
+    *out++ = 0x80 | (c & 0x3f);
+  }
+  else
+  {
+    *out++ = 0xe0 | (c >> 12);
+    *out++ = 0x80 | ((c >> 6) & 0x3f);
+    *out++ = 0x80 | (c & 0x3f);
+  }
+
+  return out;
+}
+
+/*
+ * A bulk converter encodes ordinary code units from @in to *@out, at most
+ * 3 bytes each, up to the first special one or @n_units, and returns the
+ * number of code units consumed.
+ */
+typedef gsize (*BulkFunc) (guint8 **out, const guint8 *in, gsize n_units);
+
+static gsize bulk_scalar (guint8 **out, const guint8 *in, gsize n_units)
+{
+  guint8 *p = *out;
+  gsize   i;
+
+  for (i = 0; i < n_units; i++)
+  {
+    guint16 c = GSF_LE_GET_GUINT16 (in + 2 * i);
+
+    if (is_special (c))
+      break;
+
+    p = put_utf8 (p, c);
+  }
+
+  *out = p;
+  return i;
+}
+
+#ifdef HWP_HAVE_X86_SIMD
+
+/* lanes of @c in [lo, hi], unsigned */
+#define IN_RANGE_128(c, lo, hi)                                             \
+  _mm_cmpeq_epi16 (_mm_subs_epu16 (_mm_sub_epi16 ((c), _mm_set1_epi16 (lo)),\
+                                   _mm_set1_epi16 ((hi) - (lo))),           \
+                   _mm_setzero_si128 ())
+#define LE_128(c, hi) IN_RANGE_128 (c, 0, hi)
+
+#define IN_RANGE_256(c, lo, hi)                                                   \
+  _mm256_cmpeq_epi16 (_mm256_subs_epu16 (_mm256_sub_epi16 ((c), _mm256_set1_epi16 (lo)),\
+                                         _mm256_set1_epi16 ((hi) - (lo))),        \
+                      _mm256_setzero_si256 ())
+#define LE_256(c, hi) IN_RANGE_256 (c, 0, hi)
+
+__attribute__ ((target ("sse2")))
+static gsize bulk_sse2 (guint8 **out, const guint8 *in, gsize n_units)
+{
+  guint8 *p = *out;
+  gsize   i = 0;
+
+  for (; i + 8 <= n_units; i += 8)
+  {
+    __m128i c = _mm_loadu_si128 ((const __m128i *) (in + 2 * i));
+    __m128i special = _mm_or_si128 (_mm_or_si128 (LE_128 (c, 0x1f),
+                                    IN_RANGE_128 (c, 0xd800, 0xdfff)),
+                                    IN_RANGE_128 (c, HYPUA_FIRST, HYPUA_LAST));
+
+    if (_mm_movemask_epi8 (special))
+      break;
+
+    if (_mm_movemask_epi8 (LE_128 (c, 0x7f)) == 0xffff)
+    {
+      /* ASCII */
+      _mm_storel_epi64 ((__m128i *) p, _mm_packus_epi16 (c, c));
+      p += 8;
+    }
+    else if (_mm_movemask_epi8 (LE_128 (c, 0x7ff)) == 0)
+    {
+      /* 3 bytes each, e.g. Hangul syllables */
+      guint16 b[3][8];
+      __m128i m6 = _mm_set1_epi16 (0x3f);
+      __m128i hi = _mm_set1_epi16 (0x80);
+
+      _mm_storeu_si128 ((__m128i *) b[0],
+                        _mm_or_si128 (_mm_srli_epi16 (c, 12), _mm_set1_epi16 (0xe0)));
+      _mm_storeu_si128 ((__m128i *) b[1],
+                        _mm_or_si128 (_mm_and_si128 (_mm_srli_epi16 (c, 6), m6), hi));
+      _mm_storeu_si128 ((__m128i *) b[2],
+                        _mm_or_si128 (_mm_and_si128 (c, m6), hi));
+
+      for (guint k = 0; k < 8; k++)
+      {
+        *p++ = b[0][k];
+        *p++ = b[1][k];
+        *p++ = b[2][k];
+      }
+    }
+    else
+    {
+      for (guint k = 0; k < 8; k++)
+        p = put_utf8 (p, GSF_LE_GET_GUINT16 (in + 2 * (i + k)));
+    }
+  }
+
+  *out = p;
+  return i + bulk_scalar (out, in + 2 * i, n_units - i);
+}
+
+/* encodes 8 code units in [0x800, 0xffff] as 24 bytes */
+__attribute__ ((target ("avx2")))
+static inline guint8 *put_utf8_x8_3byte (guint8 *p, __m128i c)
+{
+  __m128i m6  = _mm_set1_epi16 (0x3f);
+  __m128i hi  = _mm_set1_epi16 (0x80);
+  __m128i b0  = _mm_or_si128 (_mm_srli_epi16 (c, 12), _mm_set1_epi16 (0xe0));
+  __m128i b1  = _mm_or_si128 (_mm_and_si128 (_mm_srli_epi16 (c, 6), m6), hi);
+  __m128i b2  = _mm_or_si128 (_mm_and_si128 (c, m6), hi);
+  /* p01: b0[0..7] b1[0..7], p2: b2[0..7] */
+  __m128i p01 = _mm_packus_epi16 (b0, b1);
+  __m128i p2  = _mm_packus_epi16 (b2, b2);
+
+  __m128i lo = _mm_or_si128 (
+    _mm_shuffle_epi8 (p01, _mm_setr_epi8 (0, 8, -1, 1, 9, -1, 2, 10,
+                                          -1, 3, 11, -1, 4, 12, -1, 5)),
+    _mm_shuffle_epi8 (p2,  _mm_setr_epi8 (-1, -1, 0, -1, -1, 1, -1, -1,
+                                          2, -1, -1, 3, -1, -1, 4, -1)));
+  __m128i up = _mm_or_si128 (
+    _mm_shuffle_epi8 (p01, _mm_setr_epi8 (13, -1, 6, 14, -1, 7, 15, -1,
+                                          -1, -1, -1, -1, -1, -1, -1, -1)),
+    _mm_shuffle_epi8 (p2,  _mm_setr_epi8 (-1, 5, -1, -1, 6, -1, -1, 7,
+                                          -1, -1, -1, -1, -1, -1, -1, -1)));
+
+  _mm_storeu_si128 ((__m128i *) p, lo);
+  _mm_storel_epi64 ((__m128i *) (p + 16), up);
+
+  return p + 24;
+}
+
+__attribute__ ((target ("avx2")))
+static gsize bulk_avx2 (guint8 **out, const guint8 *in, gsize n_units)
+{
+  guint8 *p = *out;
+  gsize   i = 0;
+
+  for (; i + 16 <= n_units; i += 16)
+  {
+    __m256i c = _mm256_loadu_si256 ((const __m256i *) (in + 2 * i));
+    __m256i special = _mm256_or_si256 (_mm256_or_si256 (LE_256 (c, 0x1f),
+                                       IN_RANGE_256 (c, 0xd800, 0xdfff)),
+                                       IN_RANGE_256 (c, HYPUA_FIRST, HYPUA_LAST));
+
+    if (_mm256_movemask_epi8 (special))
+      break;
+
+    if (_mm256_movemask_epi8 (LE_256 (c, 0x7f)) == -1)
+    {
+      /* ASCII: pack works per 128-bit lane, gather qwords 0 and 2 */
+      __m256i packed = _mm256_permute4x64_epi64 (_mm256_packus_epi16 (c, c),
+                                                 _MM_SHUFFLE (3, 1, 2, 0));
+      _mm_storeu_si128 ((__m128i *) p, _mm256_castsi256_si128 (packed));
+      p += 16;
+    }
+    else if (_mm256_movemask_epi8 (LE_256 (c, 0x7ff)) == 0)
+    {
+      /* 3 bytes each, e.g. Hangul syllables */
+      p = put_utf8_x8_3byte (p, _mm256_castsi256_si128 (c));
+      p = put_utf8_x8_3byte (p, _mm256_extracti128_si256 (c, 1));
+    }
+    else
+    {
+      for (guint k = 0; k < 16; k++)
+        p = put_utf8 (p, GSF_LE_GET_GUINT16 (in + 2 * (i + k)));
+    }
+  }
+
+  *out = p;
+  return i + bulk_sse2 (out, in + 2 * i, n_units - i);
+}
+
+#endif /* HWP_HAVE_X86_SIMD */
+
+static BulkFunc get_bulk_func (void)
+{
+  static gsize    once = 0;
+  static BulkFunc func = bulk_scalar;
+
+  if (g_once_init_enter (&once))
+  {
+#ifdef HWP_HAVE_X86_SIMD
+    __builtin_cpu_init ();
+
+    if (__builtin_cpu_supports ("avx2"))
+      func = bulk_avx2;
+    else if (__builtin_cpu_supports ("sse2"))
+      func = bulk_sse2;
+#endif
+    g_once_init_leave (&once, 1);
+  }
+
+  return func;
+}
+
+/* handles the special code unit at @i; returns the index after it */
+static gsize append_special (GString      *string,
+                             const guint8 *data,
+                             gsize         i,
+                             gsize         n_units)
+{
+  guint16 c = GSF_LE_GET_GUINT16 (data + 2 * i);
+
+  if (c >= HYPUA_FIRST && c <= HYPUA_LAST)
+  {
+    /* 한양PUA 코드: 최대 세 글자로 바꾼다 */
+    hwp_hychar_append_utf8 (c, string);
+    return i + 1;
+  }
+
+  if (c >= 0xd800 && c <= 0xdfff)
+  {
+    guint16 c2;
+
+    if (c <= 0xdbff && i + 1 < n_units &&
+        (c2 = GSF_LE_GET_GUINT16 (data + 2 * (i + 1))) >= 0xdc00 &&
+        c2 <= 0xdfff)
+    {
+      g_string_append_unichar (string,
+                               0x10000 + ((c - 0xd800) << 10) + (c2 - 0xdc00));
+      return i + 2;
+    }
+
+    /* 짝이 없는 서로게이트 */
+    g_string_append_unichar (string, 0xfffd);
+    return i + 1;
+  }
+
+  switch (c)
+  {
+    /* char controls take a single code unit */
+    case 0:
+    case 10:
+    case 13:
+    case 24:
+    case 25:
+    case 26:
+    case 27:
+    case 28:
+    case 29:
+    case 30:
+    case 31:
+      return i + 1;
+    case 9: /* inline */ /* tab */
+      g_string_append_c (string, '\t');
+      return i + 8;
+    /* inline and extended controls take eight code units */
+    default:
+      return i + 8;
+  }
+}
+
+/* the decoding loop, with @bulk for the ordinary runs; the tests run it
+ * with each bulk converter */
+static void para_text_append (GString      *string,
+                              const guint8 *data,
+                              gsize         n_units,
+                              BulkFunc      bulk)
+{
+  gsize i = 0;
+
+  while (i < n_units)
+  {
+    gsize   len = string->len;
+    guint8 *out;
+
+    /* room for 3 bytes per code unit, trimmed after the bulk pass */
+    g_string_set_size (string, len + 3 * (n_units - i));
+    out = (guint8 *) string->str + len;
+    i += bulk (&out, data + 2 * i, n_units - i);
+    g_string_truncate (string, out - (guint8 *) string->str);
+
+    if (i < n_units)
+      i = append_special (string, data, i, n_units);
+  }
+}
+
+/*
+ * Appends the text of @n_units UTF-16LE code units of HWP_TAG_PARA_TEXT
+ * data at @data to @string, as UTF-8.  Control characters are dropped,
+ * except tabs; HyPUA code points are converted to Unicode.
+ */
+void _hwp_para_text_append (GString      *string,
+                            const guint8 *data,
+                            gsize         n_units)
+{
+  para_text_append (string, data, n_units, get_bulk_func ());
+}
@@ -42,6 +42,8 @@
 #include "hwp-hwp3-parser.h"
 #include "hwp-hwpml-file.h"
 #include "hwp-hwpml-parser.h"
+#include "hwp-hwpx-file.h"
+#include "hwp-hwpx-parser.h"
 
 G_DEFINE_TYPE (HwpParser, hwp_parser, G_TYPE_OBJECT);
 
@@ -82,21 +84,34 @@ HwpParser *hwp_parser_new (HwpListenable *listenable,
 }
 
 /**
- * hwp_parser_parse:
- * @parser:a #HwpParser
- * @file: a #HwpFile
- * @error: a #GError
+ * hwp_parser_set_flags:
+ * @parser: a #HwpParser
+ * @flags: a set of #HwpParseFlags
  *
- * Since: 0.1
+ * Sets what hwp_parser_parse() reads.  With
+ * %HWP_PARSE_FLAGS_METADATA_ONLY only the document version, the summary
+ * information and the preview text are reported, for every file format.
+ *
+ * Since: 2016.06.01
  */
-void hwp_parser_parse (HwpParser *parser, HwpFile *file, GError **error)
+void hwp_parser_set_flags (HwpParser *parser, HwpParseFlags flags)
 {
-  g_return_if_fail (HWP_IS_PARSER (parser) && HWP_IS_FILE (file));
+  g_return_if_fail (HWP_IS_PARSER (parser));
 
+  parser->flags = flags;
+}
+
+static gboolean hwp_parser_parse_real (HwpParser    *parser,
+                                       HwpFile      *file,
+                                       GCancellable *cancellable,
+                                       GError      **error)
+{
   if (HWP_IS_HWP5_FILE (file))
   {
     HwpHWP5Parser *parser5;
     parser5 = hwp_hwp5_parser_new (parser->listenable, parser->user_data);
+    parser5->flags       = parser->flags;
+    parser5->cancellable = cancellable;
     hwp_hwp5_parser_parse (parser5, HWP_HWP5_FILE (file), error);
     g_object_unref (parser5);
   }
@@ -104,14 +119,131 @@ void hwp_parser_parse (HwpParser *parser, HwpFile *file, GError **error)
   {
     HwpHWPMLParser *parser_ml;
     parser_ml = hwp_hwpml_parser_new (parser->listenable, parser->user_data);
+    parser_ml->flags       = parser->flags;
+    parser_ml->cancellable = cancellable;
     hwp_hwpml_parser_parse (parser_ml, HWP_HWPML_FILE (file), error);
     g_object_unref (parser_ml);
   }
+  else if (HWP_IS_HWPX_FILE (file))
+  {
+    HwpHWPXParser *parser_x;
+    parser_x = hwp_hwpx_parser_new (parser->listenable, parser->user_data);
+    parser_x->flags       = parser->flags;
+    parser_x->cancellable = cancellable;
+    hwp_hwpx_parser_parse (parser_x, HWP_HWPX_FILE (file), error);
+    g_object_unref (parser_x);
+  }
   else if (HWP_IS_HWP3_FILE (file))
   {
     HwpHWP3Parser *parser3;
     parser3 = hwp_hwp3_parser_new (parser->listenable, parser->user_data);
+    parser3->flags       = parser->flags;
+    parser3->cancellable = cancellable;
     hwp_hwp3_parser_parse (parser3, HWP_HWP3_FILE (file), error);
     g_object_unref (parser3);
   }
+
+  return *error == NULL;
+}
+
+/**
+ * hwp_parser_parse:
+ * @parser:a #HwpParser
+ * @file: a #HwpFile
+ * @error: a #GError
+ *
+ * Parses @file, reporting what is read to the listener of @parser.
+ *
+ * Different documents may be opened with the hwp_file_new_for_*()
+ * functions and parsed on different threads at the same time; libhwp
+ * keeps no global state.  A single #HwpFile or #HwpParser must not be
+ * used from several threads at once, except through the parallel
+ * #HwpParseFlags, which synchronize access themselves.
+ *
+ * Since: 0.1
+ */
+void hwp_parser_parse (HwpParser *parser, HwpFile *file, GError **error)
+{
+  GError *tmp_error = NULL;
+
+  g_return_if_fail (HWP_IS_PARSER (parser) && HWP_IS_FILE (file));
+
+  if (!hwp_parser_parse_real (parser, file, NULL, &tmp_error))
+    g_propagate_error (error, tmp_error);
+}
+
+static void parse_thread (GTask        *task,
+                          gpointer      source_object,
+                          gpointer      task_data,
+                          GCancellable *cancellable)
+{
+  GError *error = NULL;
+
+  if (hwp_parser_parse_real (HWP_PARSER (source_object),
+                             HWP_FILE (task_data), cancellable, &error))
+    g_task_return_boolean (task, TRUE);
+  else
+    g_task_return_error (task, error);
+}
+
+/**
+ * hwp_parser_parse_async:
+ * @parser: a #HwpParser
+ * @file: a #HwpFile
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore
+ * @callback: (scope async): a #GAsyncReadyCallback to call when done
+ * @user_data: (closure): the data to pass to @callback
+ *
+ * Parses @file on a worker thread of the GIO thread pool.  When it is
+ * done, @callback is called in the thread-default main context of the
+ * caller; call hwp_parser_parse_finish() from it to get the result.
+ *
+ * The listener of @parser is called from the worker thread, not from
+ * that main context.
+ *
+ * @cancellable is checked between records, paragraphs and elements, so
+ * a cancelled parse stops soon and releases the streams it holds before
+ * @callback sees %G_IO_ERROR_CANCELLED.  @parser and @file are kept
+ * alive until then.
+ *
+ * Since: 2016.06.01
+ */
+void hwp_parser_parse_async (HwpParser           *parser,
+                             HwpFile             *file,
+                             GCancellable        *cancellable,
+                             GAsyncReadyCallback  callback,
+                             gpointer             user_data)
+{
+  GTask *task;
+
+  g_return_if_fail (HWP_IS_PARSER (parser) && HWP_IS_FILE (file));
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  task = g_task_new (parser, cancellable, callback, user_data);
+  g_task_set_source_tag (task, hwp_parser_parse_async);
+  g_task_set_task_data (task, g_object_ref (file), g_object_unref);
+  g_task_run_in_thread (task, parse_thread);
+  g_object_unref (task);
+}
+
+/**
+ * hwp_parser_parse_finish:
+ * @parser: a #HwpParser
+ * @result: a #GAsyncResult
+ * @error: location to store the error occurring, or %NULL to ignore
+ *
+ * Finishes a parse started with hwp_parser_parse_async().
+ *
+ * Returns: %TRUE if @file was parsed to the end, %FALSE if @error is set
+ *
+ * Since: 2016.06.01
+ */
+gboolean hwp_parser_parse_finish (HwpParser     *parser,
+                                  GAsyncResult  *result,
+                                  GError       **error)
+{
+  g_return_val_if_fail (HWP_IS_PARSER (parser), FALSE);
+  g_return_val_if_fail (g_task_is_valid (result, parser), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
 }
@@ -43,8 +43,10 @@
 #define __HWP_PARSER_H__
 
 #include <glib-object.h>
+#include <gio/gio.h>
 #include "hwp-listenable.h"
 #include "hwp-file.h"
+#include "hwp-enums.h"
 
 G_BEGIN_DECLS
 
@@ -64,6 +66,7 @@ struct _HwpParser
 
   HwpListenable *listenable;
   gpointer       user_data;
+  HwpParseFlags  flags;
 };
 
 /**
@@ -79,11 +82,21 @@ struct _HwpParserClass
 
 GType hwp_parser_get_type (void) G_GNUC_CONST;
 
-HwpParser *hwp_parser_new   (HwpListenable *listenable,
-                             gpointer       user_data);
-void       hwp_parser_parse (HwpParser     *parser,
-                             HwpFile       *file,
-                             GError       **error);
+HwpParser *hwp_parser_new          (HwpListenable       *listenable,
+                                    gpointer             user_data);
+void       hwp_parser_set_flags    (HwpParser           *parser,
+                                    HwpParseFlags        flags);
+void       hwp_parser_parse        (HwpParser           *parser,
+                                    HwpFile             *file,
+                                    GError             **error);
+void       hwp_parser_parse_async  (HwpParser           *parser,
+                                    HwpFile             *file,
+                                    GCancellable        *cancellable,
+                                    GAsyncReadyCallback  callback,
+                                    gpointer             user_data);
+gboolean   hwp_parser_parse_finish (HwpParser           *parser,
+                                    GAsyncResult        *result,
+                                    GError             **error);
 
 G_END_DECLS
 
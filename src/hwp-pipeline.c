@@ -0,0 +1,258 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/*
+ * hwp-pipeline.c
+ * This file is part of the libhwp project.
+ *
+ * Copyright (C) 2016 Hodong Kim <cogniti@gmail.com>
+ *
+ * The libhwp is dual licensed under the LGPL v3+ or Apache License 2.0
+ *
+ * The libhwp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The libhwp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program;  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Or,
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Plumbing for the pipelined parse mode: a blocking queue with a fixed
+ * capacity, and an input stream that reads the GBytes chunks pushed into
+ * such a queue by another thread.
+ */
+
+#include <string.h>
+
+#include "hwp-pipeline.h"
+
+/* HwpBoundedQueue *********************************************************/
+
+struct _HwpBoundedQueue
+{
+  GMutex          lock;
+  GCond           not_empty;
+  GCond           not_full;
+  GQueue          items;
+  guint           capacity;
+  gboolean        closed;    /* no more pushes, pops drain the rest */
+  gboolean        cancelled; /* pushes and pops fail at once */
+  GDestroyNotify  free_func;
+};
+
+HwpBoundedQueue *_hwp_bounded_queue_new (guint          capacity,
+                                         GDestroyNotify free_func)
+{
+  g_return_val_if_fail (capacity > 0, NULL);
+
+  HwpBoundedQueue *queue = g_slice_new0 (HwpBoundedQueue);
+  g_mutex_init (&queue->lock);
+  g_cond_init (&queue->not_empty);
+  g_cond_init (&queue->not_full);
+  g_queue_init (&queue->items);
+  queue->capacity  = capacity;
+  queue->free_func = free_func;
+
+  return queue;
+}
+
+void _hwp_bounded_queue_free (HwpBoundedQueue *queue)
+{
+  g_return_if_fail (queue != NULL);
+
+  if (queue->free_func)
+    g_queue_foreach (&queue->items, (GFunc) queue->free_func, NULL);
+
+  g_queue_clear (&queue->items);
+  g_cond_clear (&queue->not_full);
+  g_cond_clear (&queue->not_empty);
+  g_mutex_clear (&queue->lock);
+  g_slice_free (HwpBoundedQueue, queue);
+}
+
+/* blocks while the queue is full; on failure @data is freed */
+gboolean _hwp_bounded_queue_push (HwpBoundedQueue *queue, gpointer data)
+{
+  g_return_val_if_fail (queue != NULL && data != NULL, FALSE);
+
+  g_mutex_lock (&queue->lock);
+
+  while (queue->items.length >= queue->capacity &&
+         !queue->closed && !queue->cancelled)
+    g_cond_wait (&queue->not_full, &queue->lock);
+
+  if (queue->closed || queue->cancelled)
+  {
+    g_mutex_unlock (&queue->lock);
+
+    if (queue->free_func)
+      queue->free_func (data);
+
+    return FALSE;
+  }
+
+  g_queue_push_tail (&queue->items, data);
+  g_cond_signal (&queue->not_empty);
+  g_mutex_unlock (&queue->lock);
+
+  return TRUE;
+}
+
+/* blocks while the queue is empty; returns NULL once it is closed and
+ * drained, or cancelled */
+gpointer _hwp_bounded_queue_pop (HwpBoundedQueue *queue)
+{
+  g_return_val_if_fail (queue != NULL, NULL);
+
+  gpointer data = NULL;
+
+  g_mutex_lock (&queue->lock);
+
+  while (queue->items.length == 0 && !queue->closed && !queue->cancelled)
+    g_cond_wait (&queue->not_empty, &queue->lock);
+
+  if (!queue->cancelled)
+  {
+    data = g_queue_pop_head (&queue->items);
+    if (data)
+      g_cond_signal (&queue->not_full);
+  }
+
+  g_mutex_unlock (&queue->lock);
+
+  return data;
+}
+
+void _hwp_bounded_queue_close (HwpBoundedQueue *queue)
+{
+  g_return_if_fail (queue != NULL);
+
+  g_mutex_lock (&queue->lock);
+  queue->closed = TRUE;
+  g_cond_broadcast (&queue->not_empty);
+  g_cond_broadcast (&queue->not_full);
+  g_mutex_unlock (&queue->lock);
+}
+
+void _hwp_bounded_queue_cancel (HwpBoundedQueue *queue)
+{
+  g_return_if_fail (queue != NULL);
+
+  g_mutex_lock (&queue->lock);
+  queue->cancelled = TRUE;
+  g_cond_broadcast (&queue->not_empty);
+  g_cond_broadcast (&queue->not_full);
+  g_mutex_unlock (&queue->lock);
+}
+
+/* HwpQueueInputStream *****************************************************/
+
+G_DEFINE_TYPE (HwpQueueInputStream, _hwp_queue_input_stream, G_TYPE_INPUT_STREAM);
+
+/*
+ * Reads the chunks of @queue in order.  An empty chunk marks the end of a
+ * section: the stream reports end-of-file until
+ * _hwp_queue_input_stream_next() is called.  The queue is not owned.
+ */
+GInputStream *_hwp_queue_input_stream_new (HwpBoundedQueue *queue)
+{
+  g_return_val_if_fail (queue != NULL, NULL);
+
+  HwpQueueInputStream *stream;
+  stream = g_object_new (HWP_TYPE_QUEUE_INPUT_STREAM, NULL);
+  stream->queue = queue;
+
+  return G_INPUT_STREAM (stream);
+}
+
+void _hwp_queue_input_stream_next (HwpQueueInputStream *stream)
+{
+  stream->eof = FALSE;
+}
+
+static gssize _hwp_queue_input_stream_read (GInputStream *base,
+                                            void         *buffer,
+                                            gsize         count,
+                                            GCancellable *cancellable,
+                                            GError      **error)
+{
+  HwpQueueInputStream *stream = HWP_QUEUE_INPUT_STREAM (base);
+  gsize                chunk_len;
+  const guint8        *data;
+
+  if (stream->eof)
+    return 0;
+
+  if (stream->chunk &&
+      stream->chunk_pos == g_bytes_get_size (stream->chunk))
+  {
+    g_bytes_unref (stream->chunk);
+    stream->chunk = NULL;
+  }
+
+  if (!stream->chunk)
+  {
+    stream->chunk     = _hwp_bounded_queue_pop (stream->queue);
+    stream->chunk_pos = 0;
+
+    /* the producer is gone, or this is the section end marker */
+    if (!stream->chunk || g_bytes_get_size (stream->chunk) == 0)
+    {
+      if (stream->chunk)
+        g_bytes_unref (stream->chunk);
+
+      stream->chunk = NULL;
+      stream->eof   = TRUE;
+      return 0;
+    }
+  }
+
+  data      = g_bytes_get_data (stream->chunk, &chunk_len);
+  count     = MIN (count, chunk_len - stream->chunk_pos);
+  memcpy (buffer, data + stream->chunk_pos, count);
+  stream->chunk_pos += count;
+
+  return (gssize) count;
+}
+
+static void _hwp_queue_input_stream_finalize (GObject *object)
+{
+  HwpQueueInputStream *stream = HWP_QUEUE_INPUT_STREAM (object);
+
+  if (stream->chunk)
+    g_bytes_unref (stream->chunk);
+
+  G_OBJECT_CLASS (_hwp_queue_input_stream_parent_class)->finalize (object);
+}
+
+static void _hwp_queue_input_stream_class_init (HwpQueueInputStreamClass *klass)
+{
+  GObjectClass      *object_class = G_OBJECT_CLASS (klass);
+  GInputStreamClass *stream_class = G_INPUT_STREAM_CLASS (klass);
+
+  stream_class->read_fn  = _hwp_queue_input_stream_read;
+  object_class->finalize = _hwp_queue_input_stream_finalize;
+}
+
+static void _hwp_queue_input_stream_init (HwpQueueInputStream *stream)
+{
+}
@@ -0,0 +1,88 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/*
+ * hwp-pipeline.h
+ * This file is part of the libhwp project.
+ *
+ * Copyright (C) 2016 Hodong Kim <cogniti@gmail.com>
+ *
+ * The libhwp is dual licensed under the LGPL v3+ or Apache License 2.0
+ *
+ * The libhwp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The libhwp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program;  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Or,
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HWP_PIPELINE_H__
+#define __HWP_PIPELINE_H__
+
+#include <glib-object.h>
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/* HwpBoundedQueue *********************************************************/
+
+typedef struct _HwpBoundedQueue HwpBoundedQueue;
+
+HwpBoundedQueue *_hwp_bounded_queue_new    (guint           capacity,
+                                            GDestroyNotify  free_func);
+void             _hwp_bounded_queue_free   (HwpBoundedQueue *queue);
+gboolean         _hwp_bounded_queue_push   (HwpBoundedQueue *queue,
+                                            gpointer         data);
+gpointer         _hwp_bounded_queue_pop    (HwpBoundedQueue *queue);
+void             _hwp_bounded_queue_close  (HwpBoundedQueue *queue);
+void             _hwp_bounded_queue_cancel (HwpBoundedQueue *queue);
+
+/* HwpQueueInputStream *****************************************************/
+
+#define HWP_TYPE_QUEUE_INPUT_STREAM  (_hwp_queue_input_stream_get_type ())
+#define HWP_QUEUE_INPUT_STREAM(obj)  (G_TYPE_CHECK_INSTANCE_CAST ((obj), HWP_TYPE_QUEUE_INPUT_STREAM, HwpQueueInputStream))
+
+typedef struct _HwpQueueInputStream      HwpQueueInputStream;
+typedef struct _HwpQueueInputStreamClass HwpQueueInputStreamClass;
+
+struct _HwpQueueInputStream
+{
+  GInputStream     parent_instance;
+
+  HwpBoundedQueue *queue;
+  GBytes          *chunk;
+  gsize            chunk_pos;
+  gboolean         eof;
+};
+
+struct _HwpQueueInputStreamClass
+{
+  GInputStreamClass parent_class;
+};
+
+GType         _hwp_queue_input_stream_get_type (void) G_GNUC_CONST;
+GInputStream *_hwp_queue_input_stream_new      (HwpBoundedQueue *queue);
+void          _hwp_queue_input_stream_next     (HwpQueueInputStream *stream);
+
+G_END_DECLS
+
+#endif /* __HWP_PIPELINE_H__ */
@@ -0,0 +1,268 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/*
+ * hwp-record-iter.c
+ * This file is part of the libhwp project.
+ *
+ * Copyright (C) 2016 Hodong Kim <cogniti@gmail.com>
+ *
+ * The libhwp is dual licensed under the LGPL v3+ or Apache License 2.0
+ *
+ * The libhwp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The libhwp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program;  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Or,
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <glib/gi18n-lib.h>
+#include <gsf/gsf-utils.h>
+
+#include "hwp-enums.h"
+#include "hwp-file-private.h"
+#include "hwp-record-iter.h"
+
+/**
+ * hwp_record_iter_init_bytes:
+ * @iter: an uninitialized #HwpRecordIter
+ * @bytes: records, already inflated
+ *
+ * Initializes @iter to walk the records in @bytes, which it references.
+ *
+ * Since: 2016.06.01
+ */
+void hwp_record_iter_init_bytes (HwpRecordIter *iter, GBytes *bytes)
+{
+  g_return_if_fail (iter != NULL);
+  g_return_if_fail (bytes != NULL);
+
+  iter->bytes = g_bytes_ref (bytes);
+  iter->data  = g_bytes_get_data (bytes, &iter->len);
+  iter->pos   = 0;
+  iter->level = 0;
+}
+
+/**
+ * hwp_record_iter_init_doc_info:
+ * @iter: an uninitialized #HwpRecordIter
+ * @file: a #HwpHWP5File
+ * @error: location to store the error occurring, or %NULL to ignore
+ *
+ * Inflates the DocInfo stream of @file into one buffer and initializes
+ * @iter to walk its records.  On failure @iter is left cleared, so
+ * hwp_record_iter_clear() may still be called on it.
+ *
+ * Returns: %TRUE on success
+ *
+ * Since: 2016.06.01
+ */
+gboolean hwp_record_iter_init_doc_info (HwpRecordIter  *iter,
+                                        HwpHWP5File    *file,
+                                        GError        **error)
+{
+  g_return_val_if_fail (iter != NULL, FALSE);
+  g_return_val_if_fail (HWP_IS_HWP5_FILE (file), FALSE);
+
+  GBytes *bytes = _hwp_hwp5_file_read_doc_info (file, error);
+
+  memset (iter, 0, sizeof *iter);
+
+  if (!bytes)
+    return FALSE;
+
+  hwp_record_iter_init_bytes (iter, bytes);
+  g_bytes_unref (bytes);
+
+  return TRUE;
+}
+
+/**
+ * hwp_record_iter_init_section:
+ * @iter: an uninitialized #HwpRecordIter
+ * @file: a #HwpHWP5File
+ * @index: the index of the section
+ * @error: location to store the error occurring, or %NULL to ignore
+ *
+ * Decrypts and inflates the @index-th section of @file into one buffer
+ * and initializes @iter to walk its records.  Iterators over different
+ * sections may be used on different threads.  On failure @iter is left
+ * cleared, so hwp_record_iter_clear() may still be called on it.
+ *
+ * Returns: %TRUE on success
+ *
+ * Since: 2016.06.01
+ */
+gboolean hwp_record_iter_init_section (HwpRecordIter  *iter,
+                                       HwpHWP5File    *file,
+                                       guint           index,
+                                       GError        **error)
+{
+  g_return_val_if_fail (iter != NULL, FALSE);
+  g_return_val_if_fail (HWP_IS_HWP5_FILE (file), FALSE);
+  g_return_val_if_fail (index < hwp_hwp5_file_get_n_sections (file), FALSE);
+
+  GBytes *bytes = _hwp_hwp5_file_read_section (file, index, error);
+
+  memset (iter, 0, sizeof *iter);
+
+  if (!bytes)
+    return FALSE;
+
+  hwp_record_iter_init_bytes (iter, bytes);
+  g_bytes_unref (bytes);
+
+  return TRUE;
+}
+
+/**
+ * hwp_record_iter_next:
+ * @iter: a #HwpRecordIter
+ * @tag_id: (out) (allow-none): return location for the #HwpTag
+ * @level: (out) (allow-none): return location for the level of the record
+ * @payload: (out) (allow-none) (transfer none): return location for the
+ *   payload, valid until @iter is cleared
+ * @len: (out) (allow-none): return location for the length of @payload
+ * @error: location to store the error occurring, or %NULL to ignore
+ *
+ * Advances @iter to the next record.  Only the record header is decoded;
+ * @payload points into the buffer of @iter.
+ *
+ * Returns: %TRUE if a record was read, %FALSE at the end of the records
+ *   or if @error was set because the last record is truncated
+ *
+ * Since: 2016.06.01
+ */
+gboolean hwp_record_iter_next (HwpRecordIter  *iter,
+                               guint16        *tag_id,
+                               guint16        *level,
+                               const guint8  **payload,
+                               gsize          *len,
+                               GError        **error)
+{
+  g_return_val_if_fail (iter != NULL, FALSE);
+
+  guint32 header;
+  gsize   size;
+
+  if (iter->pos >= iter->len)
+    return FALSE;
+
+  if (iter->len - iter->pos < 4)
+    goto CORRUPTED;
+
+  header = GSF_LE_GET_GUINT32 (iter->data + iter->pos);
+  size   = (header >> 20) & 0xfff;
+  iter->pos += 4;
+
+  /* data_len == 0xfff 이면 다음 4바이트는 data_len 이다 */
+  if (size == 0xfff)
+  {
+    if (iter->len - iter->pos < 4)
+      goto CORRUPTED;
+
+    size = GSF_LE_GET_GUINT32 (iter->data + iter->pos);
+    iter->pos += 4;
+  }
+
+  if (size > iter->len - iter->pos)
+    goto CORRUPTED;
+
+  iter->level = (header >> 10) & 0x3ff;
+
+  if (tag_id)
+    *tag_id = header & 0x3ff;
+  if (level)
+    *level = iter->level;
+  if (payload)
+    *payload = iter->data + iter->pos;
+  if (len)
+    *len = size;
+
+  iter->pos += size;
+
+  return TRUE;
+
+  CORRUPTED:
+  iter->pos = iter->len;
+  g_set_error_literal (error, HWP_ERROR, HWP_ERROR_INVALID,
+                       _("File corrupted"));
+  return FALSE;
+}
+
+/**
+ * hwp_record_iter_skip_children:
+ * @iter: a #HwpRecordIter
+ * @error: location to store the error occurring, or %NULL to ignore
+ *
+ * Skips the records below the one last returned by
+ * hwp_record_iter_next(), reading only their headers, so that the next
+ * call returns its next sibling or an ancestor's sibling.
+ *
+ * Returns: %FALSE if @error was set
+ *
+ * Since: 2016.06.01
+ */
+gboolean hwp_record_iter_skip_children (HwpRecordIter *iter, GError **error)
+{
+  g_return_val_if_fail (iter != NULL, FALSE);
+
+  guint16 parent = iter->level;
+
+  /* 헤더의 level 만 보고 하위 레코드를 건너뛴다 */
+  while (iter->pos + 4 <= iter->len)
+  {
+    guint32 header = GSF_LE_GET_GUINT32 (iter->data + iter->pos);
+
+    if (((header >> 10) & 0x3ff) <= parent)
+      break;
+
+    if (!hwp_record_iter_next (iter, NULL, NULL, NULL, NULL, error))
+      return FALSE;
+  }
+
+  iter->level = parent;
+
+  return TRUE;
+}
+
+/**
+ * hwp_record_iter_clear:
+ * @iter: a #HwpRecordIter
+ *
+ * Releases the buffer of @iter; payloads it returned are no longer
+ * valid.  @iter may be initialized again afterwards.
+ *
+ * Since: 2016.06.01
+ */
+void hwp_record_iter_clear (HwpRecordIter *iter)
+{
+  g_return_if_fail (iter != NULL);
+
+  if (iter->bytes)
+    g_bytes_unref (iter->bytes);
+
+  memset (iter, 0, sizeof *iter);
+}
@@ -0,0 +1,103 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/*
+ * hwp-record-iter.h
+ * This file is part of the libhwp project.
+ *
+ * Copyright (C) 2016 Hodong Kim <cogniti@gmail.com>
+ *
+ * The libhwp is dual licensed under the LGPL v3+ or Apache License 2.0
+ *
+ * The libhwp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The libhwp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program;  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Or,
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * This software has been developed with reference to
+ * the HWP file format open specification by Hancom, Inc.
+ * http://www.hancom.co.kr/userofficedata.userofficedataList.do?menuFlag=3
+ * 한글과컴퓨터의 한/글 문서 파일(.hwp) 공개 문서를 참고하여 개발하였습니다.
+ */
+
+#if !defined (__HWP_H_INSIDE__) && !defined (HWP_COMPILATION)
+#error "Only <hwp/hwp.h> can be included directly."
+#endif
+
+#ifndef __HWP_RECORD_ITER_H__
+#define __HWP_RECORD_ITER_H__
+
+#include <glib.h>
+
+#include "hwp-hwp5-file.h"
+
+G_BEGIN_DECLS
+
+typedef struct _HwpRecordIter HwpRecordIter;
+
+/**
+ * HwpRecordIter:
+ *
+ * An iterator over the records of a HWP 5.0 stream, DocInfo or a
+ * section, once inflated.  It is allocated on the stack, initialized
+ * with one of the hwp_record_iter_init_*() functions and released with
+ * hwp_record_iter_clear().  The payloads it yields point into its buffer
+ * and are never copied.
+ *
+ * Since: 2016.06.01
+ */
+struct _HwpRecordIter
+{
+  /*< private >*/
+  GBytes       *bytes;
+  const guint8 *data;
+  gsize         len;
+  gsize         pos;
+  guint16       level;
+  gpointer      padding[4];
+};
+
+gboolean hwp_record_iter_init_doc_info (HwpRecordIter  *iter,
+                                        HwpHWP5File    *file,
+                                        GError        **error);
+gboolean hwp_record_iter_init_section  (HwpRecordIter  *iter,
+                                        HwpHWP5File    *file,
+                                        guint           index,
+                                        GError        **error);
+void     hwp_record_iter_init_bytes    (HwpRecordIter  *iter,
+                                        GBytes         *bytes);
+gboolean hwp_record_iter_next          (HwpRecordIter  *iter,
+                                        guint16        *tag_id,
+                                        guint16        *level,
+                                        const guint8  **payload,
+                                        gsize          *len,
+                                        GError        **error);
+gboolean hwp_record_iter_skip_children (HwpRecordIter  *iter,
+                                        GError        **error);
+void     hwp_record_iter_clear         (HwpRecordIter  *iter);
+
+G_END_DECLS
+
+#endif /* __HWP_RECORD_ITER_H__ */
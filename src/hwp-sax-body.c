@@ -0,0 +1,298 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/*
+ * hwp-sax-body.c
+ * This file is part of the libhwp project.
+ *
+ * Copyright (C) 2016 Hodong Kim <cogniti@gmail.com>
+ *
+ * The libhwp is dual licensed under the LGPL v3+ or Apache License 2.0
+ *
+ * The libhwp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The libhwp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program;  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Or,
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * The document body as the SAX parsers of HWPML and HWPX see it: a stack
+ * of open paragraphs and tables.  A paragraph collects its text and its
+ * character shape runs, recorded the way the HWP 5.0 parser records them;
+ * a paragraph inside a cell goes to the cell, and a table goes to the
+ * paragraph it is in.  Only the element names differ between the formats.
+ */
+
+#include <string.h>
+
+#include "hwp-sax-body.h"
+
+void _hwp_sax_body_init (HwpSaxBody *body)
+{
+  body->paras  = g_array_new (FALSE, FALSE, sizeof (HwpSaxPara));
+  body->tables = g_array_new (FALSE, FALSE, sizeof (HwpSaxTable));
+}
+
+/* 문서가 끊겼을 때 열려 있던 문단과 표를 정리한다 */
+void _hwp_sax_body_clear (HwpSaxBody *body)
+{
+  while (body->tables->len > 0)
+    _hwp_sax_end_table (body);
+
+  for (guint i = 0; i < body->paras->len; i++)
+  {
+    HwpSaxPara *para = &g_array_index (body->paras, HwpSaxPara, i);
+    g_object_unref (para->paragraph);
+    g_string_free (para->text, TRUE);
+    if (para->m_id)
+    {
+      g_array_free (para->m_id, TRUE);
+      g_array_free (para->m_offset, TRUE);
+    }
+  }
+
+  g_array_free (body->paras, TRUE);
+  g_array_free (body->tables, TRUE);
+}
+
+HwpSaxPara *_hwp_sax_top_para (HwpSaxBody *body)
+{
+  if (body->paras->len == 0)
+    return NULL;
+
+  return &g_array_index (body->paras, HwpSaxPara, body->paras->len - 1);
+}
+
+HwpSaxTable *_hwp_sax_top_table (HwpSaxBody *body)
+{
+  if (body->tables->len == 0)
+    return NULL;
+
+  return &g_array_index (body->tables, HwpSaxTable, body->tables->len - 1);
+}
+
+void _hwp_sax_begin_paragraph (HwpSaxBody *body, gboolean with_runs)
+{
+  HwpSaxPara para = { 0 };
+
+  para.paragraph = hwp_paragraph_new ();
+  para.text      = g_string_new (NULL);
+
+  if (with_runs)
+  {
+    para.m_id     = g_array_new (FALSE, FALSE, sizeof (guint32));
+    para.m_offset = g_array_new (FALSE, FALSE, sizeof (guint32));
+  }
+
+  g_array_append_val (body->paras, para);
+}
+
+/* a run starts at the current end of the text */
+void _hwp_sax_add_run (HwpSaxPara *para, guint32 id)
+{
+  guint32 offset = para->text->len;
+
+  if (!para->m_id)
+    return;
+
+  g_array_append_val (para->m_id, id);
+  g_array_append_val (para->m_offset, offset);
+}
+
+/* closes the top paragraph; returns it, or %NULL if it went to a cell */
+HwpParagraph *_hwp_sax_end_paragraph (HwpSaxBody *body, guint section_index)
+{
+  HwpSaxPara    para      = *_hwp_sax_top_para (body);
+  HwpSaxTable  *table     = _hwp_sax_top_table (body);
+  HwpParagraph *paragraph = para.paragraph;
+
+  g_array_set_size (body->paras, body->paras->len - 1);
+
+  paragraph->n_chars       = g_utf8_strlen (para.text->str, para.text->len);
+  paragraph->section_index = section_index;
+
+  /* runs as the HWP 5.0 parser records them: m_pos in characters,
+   * m_offset in bytes of text with one more entry for the end */
+  if (para.m_id && para.m_id->len > 0 && para.m_id->len <= G_MAXUINT16)
+  {
+    guint32     end = para.text->len;
+    const char *ptr = para.text->str;
+    guint32     pos = 0;
+
+    paragraph->m_len = para.m_id->len;
+    paragraph->m_pos = g_new (guint32, paragraph->m_len);
+
+    for (guint i = 0; i < paragraph->m_len; i++)
+    {
+      const char *next = para.text->str + g_array_index (para.m_offset, guint32, i);
+
+      pos += g_utf8_strlen (ptr, next - ptr);
+      ptr  = next;
+      paragraph->m_pos[i] = pos;
+    }
+
+    g_array_append_val (para.m_offset, end);
+    paragraph->m_id     = (guint32 *) g_array_free (para.m_id, FALSE);
+    paragraph->m_offset = (guint32 *) g_array_free (para.m_offset, FALSE);
+  }
+  else if (para.m_id)
+  {
+    g_array_free (para.m_id, TRUE);
+    g_array_free (para.m_offset, TRUE);
+  }
+
+  paragraph->text = g_string_free (para.text, FALSE);
+
+  /* 셀 안의 문단은 셀에 담고, 표는 바깥 문단과 함께 넘어간다 */
+  if (table && table->cell && table->depth == body->paras->len)
+  {
+    hwp_table_cell_add_paragraph (table->cell, paragraph);
+    return NULL;
+  }
+
+  return paragraph;
+}
+
+HwpSaxTable *_hwp_sax_begin_table (HwpSaxBody *body,
+                                   guint16     n_rows,
+                                   guint16     n_cols)
+{
+  HwpSaxTable t;
+
+  t.table = hwp_table_new ();
+  t.cell  = NULL;
+  t.depth = body->paras->len;
+
+  t.table->n_rows = n_rows;
+  t.table->n_cols = n_cols;
+
+  for (guint i = 0; i < t.table->n_rows; i++)
+    g_ptr_array_add (t.table->rows, g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref));
+
+  g_array_append_val (body->tables, t);
+
+  return _hwp_sax_top_table (body);
+}
+
+void _hwp_sax_end_table (HwpSaxBody *body)
+{
+  HwpSaxTable  t    = *_hwp_sax_top_table (body);
+  HwpSaxPara  *para = _hwp_sax_top_para (body);
+
+  g_array_set_size (body->tables, body->tables->len - 1);
+
+  /* 닫히지 않은 셀은 버린다 */
+  if (t.cell)
+    g_object_unref (t.cell);
+
+  if (para && !para->paragraph->table)
+    hwp_paragraph_set_table (para->paragraph, t.table);
+  else
+    g_object_unref (t.table);
+}
+
+/* the cell is added to its row only when it is closed, since HWPX gives
+ * its address after its paragraphs */
+void _hwp_sax_end_cell (HwpSaxTable *t)
+{
+  HwpTableCell *cell = t->cell;
+
+  t->cell = NULL;
+  cell->n_paragraphs = cell->paragraphs->len;
+
+  if (cell->row_addr < t->table->rows->len)
+  {
+    hwp_table_add_cell (t->table, cell, cell->row_addr);
+  }
+  else
+  {
+    g_warning ("%s:%d: cell out of rows\n", __FILE__, __LINE__);
+    g_object_unref (cell);
+  }
+}
+
+/* attributes of startElementNs are (localname, prefix, URI, value, end);
+ * HWPML names are matched without case, OWPML names with it.  A value
+ * that does not fit in @max is saturated to it rather than wrapped */
+static guint32 attr_uint (int             n_attributes,
+                          const xmlChar **attributes,
+                          const gchar    *name,
+                          gboolean        ignore_case,
+                          guint32         max)
+{
+  for (int i = 0; i < n_attributes; i++)
+  {
+    const xmlChar **attr  = attributes + i * 5;
+    const gchar    *local = (const gchar *) attr[0];
+
+    if (ignore_case ? g_ascii_strcasecmp (local, name) == 0
+                    : strcmp (local, name) == 0)
+    {
+      const xmlChar *p   = attr[3];
+      guint32        val = 0;
+
+      while (p < attr[4] && g_ascii_isdigit (*p))
+      {
+        guint digit = *p++ - '0';
+
+        if (val > (max - digit) / 10)
+          return max;
+
+        val = val * 10 + digit;
+      }
+
+      return val;
+    }
+  }
+
+  return 0;
+}
+
+guint32 _hwp_sax_attr_uint (int             n_attributes,
+                            const xmlChar **attributes,
+                            const gchar    *name,
+                            gboolean        ignore_case)
+{
+  return attr_uint (n_attributes, attributes, name, ignore_case, G_MAXUINT32);
+}
+
+/* for the guint16 fields of the models, such as the row and column
+ * counts of #HwpTable */
+guint16 _hwp_sax_attr_uint16 (int             n_attributes,
+                              const xmlChar **attributes,
+                              const gchar    *name,
+                              gboolean        ignore_case)
+{
+  return attr_uint (n_attributes, attributes, name, ignore_case, G_MAXUINT16);
+}
+
+int _hwp_sax_read_memory (void *context, char *buffer, int len)
+{
+  HwpSaxMemory *memory = context;
+
+  len = (int) MIN ((gsize) len, (gsize) (memory->end - memory->pos));
+  memcpy (buffer, memory->pos, len);
+  memory->pos += len;
+
+  return len;
+}
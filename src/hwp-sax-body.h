@@ -0,0 +1,105 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/*
+ * hwp-sax-body.h
+ * This file is part of the libhwp project.
+ *
+ * Copyright (C) 2016 Hodong Kim <cogniti@gmail.com>
+ *
+ * The libhwp is dual licensed under the LGPL v3+ or Apache License 2.0
+ *
+ * The libhwp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The libhwp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program;  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Or,
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HWP_SAX_BODY_H__
+#define __HWP_SAX_BODY_H__
+
+#include <glib.h>
+#include <libxml/parser.h>
+
+#include "hwp-models.h"
+
+G_BEGIN_DECLS
+
+/* an open paragraph */
+typedef struct {
+  HwpParagraph *paragraph;
+  GString      *text;
+  GArray       *m_id;     /* char shape of each run; NULL with TEXT_ONLY */
+  GArray       *m_offset; /* byte offset of each run in text */
+  guint         in_text;  /* depth of the open elements holding text */
+} HwpSaxPara;
+
+/* an open table */
+typedef struct {
+  HwpTable     *table;
+  HwpTableCell *cell;  /* the open cell, owned until _hwp_sax_end_cell() */
+  guint         depth; /* number of open paragraphs when the table began */
+} HwpSaxTable;
+
+/* the paragraphs and tables open at the current element */
+typedef struct {
+  GArray *paras;  /* HwpSaxPara */
+  GArray *tables; /* HwpSaxTable */
+} HwpSaxBody;
+
+/* libxml2 read callback over a buffer */
+typedef struct {
+  const guint8 *pos;
+  const guint8 *end;
+} HwpSaxMemory;
+
+void          _hwp_sax_body_init       (HwpSaxBody     *body);
+void          _hwp_sax_body_clear      (HwpSaxBody     *body);
+HwpSaxPara   *_hwp_sax_top_para        (HwpSaxBody     *body);
+HwpSaxTable  *_hwp_sax_top_table       (HwpSaxBody     *body);
+void          _hwp_sax_begin_paragraph (HwpSaxBody     *body,
+                                        gboolean        with_runs);
+void          _hwp_sax_add_run         (HwpSaxPara     *para,
+                                        guint32         id);
+HwpParagraph *_hwp_sax_end_paragraph   (HwpSaxBody     *body,
+                                        guint           section_index);
+HwpSaxTable  *_hwp_sax_begin_table     (HwpSaxBody     *body,
+                                        guint16         n_rows,
+                                        guint16         n_cols);
+void          _hwp_sax_end_table       (HwpSaxBody     *body);
+void          _hwp_sax_end_cell        (HwpSaxTable    *table);
+guint32       _hwp_sax_attr_uint       (int             n_attributes,
+                                        const xmlChar **attributes,
+                                        const gchar    *name,
+                                        gboolean        ignore_case);
+guint16       _hwp_sax_attr_uint16     (int             n_attributes,
+                                        const xmlChar **attributes,
+                                        const gchar    *name,
+                                        gboolean        ignore_case);
+int           _hwp_sax_read_memory     (void           *memory,
+                                        char           *buffer,
+                                        int             len);
+
+G_END_DECLS
+
+#endif /* __HWP_SAX_BODY_H__ */
@@ -52,9 +52,12 @@
 #include "hwp-hwp5-parser.h"
 #include "hwp-hwpml-file.h"
 #include "hwp-hwpml-parser.h"
+#include "hwp-hwpx-file.h"
+#include "hwp-hwpx-parser.h"
 #include "hwp-listenable.h"
 #include "hwp-models.h"
 #include "hwp-parser.h"
+#include "hwp-record-iter.h"
 #include "hwp-version.h"
 
 #undef __HWP_H_INSIDE__
@@ -0,0 +1,801 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/*
+ * test-concurrent-parse.c
+ * This file is part of the libhwp project.
+ *
+ * Copyright (C) 2016 Hodong Kim <cogniti@gmail.com>
+ *
+ * The libhwp is dual licensed under the LGPL v3+ or Apache License 2.0
+ *
+ * The libhwp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The libhwp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program;  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Or,
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Opens and parses several documents at the same time from several
+ * threads, once with each HwpParseFlags, and checks that every parse
+ * reports the same paragraphs as a plain parse on the main thread.
+ *
+ * The documents are built in memory: HWP5 with and without compression,
+ * a distribution HWP5 whose sections are encrypted, HWPML, HWPX and HWP3.
+ * Documents given on the command line are parsed too.
+ *
+ * The HWP5 sections also hold tables, each with a large unread record.
+ * The collector does not ask for tables, so they are skipped as whole
+ * subtrees, also in the streaming modes that inflate while reading.
+ */
+
+#include <string.h>
+#include <openssl/evp.h>
+#include <gio/gio.h>
+#include <gsf/gsf-outfile.h>
+#include <gsf/gsf-outfile-msole.h>
+#include <gsf/gsf-outfile-zip.h>
+#include <gsf/gsf-output-memory.h>
+#include <gsf/gsf-utils.h>
+#include "hwp.h"
+
+#define N_THREADS    8
+#define N_ROUNDS     4
+#define N_SECTIONS   4
+#define N_PARAGRAPHS 64
+#define TABLE_EVERY  8
+
+static const HwpParseFlags parse_flags[] =
+{
+  HWP_PARSE_FLAGS_NONE,
+  HWP_PARSE_FLAGS_METADATA_ONLY,
+  HWP_PARSE_FLAGS_PARALLEL_SECTIONS,
+  HWP_PARSE_FLAGS_PARALLEL_SECTIONS | HWP_PARSE_FLAGS_UNORDERED,
+  HWP_PARSE_FLAGS_PIPELINE,
+  HWP_PARSE_FLAGS_PARALLEL_PARAGRAPHS,
+  HWP_PARSE_FLAGS_TEXT_ONLY
+};
+
+typedef struct
+{
+  const gchar *name;
+  GBytes      *bytes;
+  gchar       *expected;        /* paragraph texts of a plain parse */
+  gchar       *expected_sorted; /* the same, sorted */
+} Document;
+
+static GPtrArray *documents;
+static gint       n_failures;
+
+/* TestCollector class ******************************************************/
+#define TEST_TYPE_COLLECTOR (test_collector_get_type ())
+
+typedef struct
+{
+  GObject    parent_instance;
+  GMutex     lock;
+  GPtrArray *texts;
+} TestCollector;
+
+typedef struct
+{
+  GObjectClass parent_class;
+} TestCollectorClass;
+
+GType test_collector_get_type (void) G_GNUC_CONST;
+
+static void test_collector_iface_init (HwpListenableInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (TestCollector, test_collector, G_TYPE_OBJECT,
+  G_IMPLEMENT_INTERFACE (HWP_TYPE_LISTENABLE, test_collector_iface_init))
+
+static void test_collector_init (TestCollector *collector)
+{
+  g_mutex_init (&collector->lock);
+  collector->texts = g_ptr_array_new_with_free_func (g_free);
+}
+
+static void test_collector_finalize (GObject *object)
+{
+  TestCollector *collector = (TestCollector *) object;
+
+  g_mutex_clear (&collector->lock);
+  g_ptr_array_unref (collector->texts);
+
+  G_OBJECT_CLASS (test_collector_parent_class)->finalize (object);
+}
+
+static void test_collector_class_init (TestCollectorClass *klass)
+{
+  G_OBJECT_CLASS (klass)->finalize = test_collector_finalize;
+}
+
+/* the parallel modes may call this from worker threads */
+static void on_paragraph (HwpListenable *listenable,
+                          HwpParagraph  *paragraph,
+                          gpointer       user_data,
+                          GError       **error)
+{
+  TestCollector *collector = (TestCollector *) listenable;
+  const gchar   *text      = hwp_paragraph_get_text (paragraph);
+
+  g_mutex_lock (&collector->lock);
+  g_ptr_array_add (collector->texts,
+                   g_strdup_printf ("%u:%s", paragraph->section_index,
+                                    text ? text : ""));
+  g_mutex_unlock (&collector->lock);
+
+  g_object_unref (paragraph);
+}
+
+static HwpEventMask get_event_mask (HwpListenable *listenable)
+{
+  return HWP_EVENT_PARAGRAPHS;
+}
+
+static void test_collector_iface_init (HwpListenableInterface *iface)
+{
+  iface->paragraph      = on_paragraph;
+  iface->get_event_mask = get_event_mask;
+}
+
+/* documents ****************************************************************/
+
+static void append_uint16 (GByteArray *array, guint16 value)
+{
+  guint8 buf[2];
+
+  GSF_LE_SET_GUINT16 (buf, value);
+  g_byte_array_append (array, buf, sizeof buf);
+}
+
+static void append_uint32 (GByteArray *array, guint32 value)
+{
+  guint8 buf[4];
+
+  GSF_LE_SET_GUINT32 (buf, value);
+  g_byte_array_append (array, buf, sizeof buf);
+}
+
+static void append_record (GByteArray   *array,
+                           guint16       tag_id,
+                           guint16       level,
+                           const guint8 *data,
+                           guint32       len)
+{
+  if (len < 0xfff)
+  {
+    append_uint32 (array, tag_id | level << 10 | len << 20);
+  }
+  else
+  {
+    append_uint32 (array, tag_id | level << 10 | 0xfffu << 20);
+    append_uint32 (array, len);
+  }
+
+  g_byte_array_append (array, data, len);
+}
+
+/* PARA_HEADER, PARA_TEXT, PARA_CHAR_SHAPE and an unread PARA_LINE_SEG */
+static void append_paragraph (GByteArray  *section,
+                              guint16      level,
+                              const gchar *text)
+{
+  GByteArray *record = g_byte_array_new ();
+  guint32     n_chars = strlen (text);
+  guint8      line_seg[36] = { 0 };
+
+  append_uint32 (record, n_chars);
+  append_uint32 (record, 0);   /* control mask */
+  append_uint16 (record, 0);   /* para shape id */
+  g_byte_array_append (record, (const guint8 *) "\0\0", 2);
+  append_uint16 (record, 1);   /* n_char_shapes */
+  append_uint16 (record, 0);   /* n_range_tags */
+  append_uint16 (record, 1);   /* n_aligns */
+  append_uint32 (record, 0);   /* instance id */
+  append_record (section, HWP_TAG_PARA_HEADER, level,
+                 record->data, record->len);
+
+  g_byte_array_set_size (record, 0);
+  for (guint i = 0; i < n_chars; i++)
+    append_uint16 (record, (guint8) text[i]);
+  append_record (section, HWP_TAG_PARA_TEXT, level + 1,
+                 record->data, record->len);
+
+  g_byte_array_set_size (record, 0);
+  append_uint32 (record, 0);
+  append_uint32 (record, 0);
+  append_record (section, HWP_TAG_PARA_CHAR_SHAPE, level + 1,
+                 record->data, record->len);
+
+  append_record (section, HWP_TAG_PARA_LINE_SEG, level + 1,
+                 line_seg, sizeof line_seg);
+
+  g_byte_array_unref (record);
+}
+
+/* a table control of the last paragraph: CTRL_HEADER, a TABLE record
+ * larger than any read buffer, and a cell holding a paragraph that must
+ * never be reported, since it is only reached by walking into the table */
+static void append_table (GByteArray *section)
+{
+  guint8  ctrl_header[46] = { 0 };
+  guint8 *table           = g_malloc0 (64 * 1024 + 1);
+
+  GSF_LE_SET_GUINT32 (ctrl_header, CTRL_ID_TABLE);
+  append_record (section, HWP_TAG_CTRL_HEADER, 1,
+                 ctrl_header, sizeof ctrl_header);
+  append_record (section, HWP_TAG_TABLE, 2, table, 64 * 1024 + 1);
+  append_record (section, HWP_TAG_LIST_HEADER, 2, table, 34);
+  append_paragraph (section, 2, "table cell");
+
+  g_free (table);
+}
+
+static GBytes *deflate_raw (GByteArray *array)
+{
+  GZlibCompressor *zc;
+  GOutputStream   *mem;
+  GOutputStream   *out;
+  GBytes          *bytes;
+
+  zc  = g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW, -1);
+  mem = g_memory_output_stream_new_resizable ();
+  out = g_converter_output_stream_new (mem, G_CONVERTER (zc));
+
+  g_output_stream_write_all (out, array->data, array->len, NULL, NULL, NULL);
+  g_output_stream_close (out, NULL, NULL);
+
+  bytes = g_memory_output_stream_steal_as_bytes (G_MEMORY_OUTPUT_STREAM (mem));
+
+  g_object_unref (out);
+  g_object_unref (mem);
+  g_object_unref (zc);
+
+  return bytes;
+}
+
+static void write_child (GsfOutfile   *parent,
+                         const gchar  *name,
+                         const guint8 *data,
+                         gsize         len)
+{
+  GsfOutput *child = gsf_outfile_new_child (parent, name, FALSE);
+
+  gsf_output_write (child, len, data);
+  gsf_output_close (child);
+  g_object_unref (child);
+}
+
+static int msvc_rand (guint32 *state)
+{
+  *state = (*state * 214013 + 2531011) & 0xffffffff;
+  return ((*state >> 16) & 0x7fff);
+}
+
+/* a distribution section: DISTRIBUTE_DOC_DATA holding the scrambled AES
+ * key, then @bytes encrypted with it.  the encrypted data is padded to
+ * the AES block size; the inflater stops at the end of the deflate
+ * stream, so the padding is never read as records */
+static GBytes *encrypt_section (GBytes *bytes)
+{
+  GByteArray     *array = g_byte_array_new ();
+  guint8          data[256];
+  guint8          key[16];
+  guint32         seed  = 0x20160601;
+  guint32         state = seed;
+  gint            n = 0, val = 0;
+  gsize           len;
+  const guint8   *plain;
+  guint8         *padded;
+  guint8         *cipher;
+  int             cipher_len = 0;
+  EVP_CIPHER_CTX *ctx;
+
+  for (guint i = 0; i < 256; i++)
+    data[i] = i * 7 + 1;
+
+  memcpy (key, data + 4 + (seed & 0xf), 16);
+
+  /* read_distribute_key () 와 같은 XOR 이므로 그대로 되돌아간다 */
+  for (guint i = 0; i < 256; i++)
+  {
+    if (n == 0)
+    {
+      val = msvc_rand (&state) & 0xff;
+      n = (msvc_rand (&state) & 0xf) + 1;
+    }
+
+    data[i] ^= val;
+
+    n--;
+  }
+
+  GSF_LE_SET_GUINT32 (data, seed);
+  append_record (array, HWP_TAG_DISTRIBUTE_DOC_DATA, 0, data, sizeof data);
+
+  plain  = g_bytes_get_data (bytes, &len);
+  padded = g_malloc0 ((len + 15) / 16 * 16);
+  cipher = g_malloc ((len + 15) / 16 * 16);
+  memcpy (padded, plain, len);
+  ctx = EVP_CIPHER_CTX_new ();
+  EVP_EncryptInit_ex (ctx, EVP_aes_128_ecb (), NULL, key, NULL);
+  EVP_CIPHER_CTX_set_padding (ctx, 0); /* no padding */
+  EVP_EncryptUpdate (ctx, cipher, &cipher_len, padded, (int) ((len + 15) / 16 * 16));
+  EVP_CIPHER_CTX_free (ctx);
+
+  g_byte_array_append (array, cipher, cipher_len);
+
+  g_free (cipher);
+  g_free (padded);
+  g_bytes_unref (bytes);
+
+  return g_byte_array_free_to_bytes (array);
+}
+
+static void write_record_stream (GsfOutfile  *parent,
+                                 const gchar *name,
+                                 GByteArray  *records,
+                                 gboolean     is_compress,
+                                 gboolean     is_distribute)
+{
+  GBytes       *bytes;
+  gsize         len;
+  const guint8 *data;
+
+  if (is_compress)
+    bytes = deflate_raw (records);
+  else
+    bytes = g_bytes_new (records->data, records->len);
+
+  if (is_distribute)
+    bytes = encrypt_section (bytes);
+
+  data = g_bytes_get_data (bytes, &len);
+  write_child (parent, name, data, len);
+  g_bytes_unref (bytes);
+}
+
+static GBytes *steal_output_memory (GsfOutput *output)
+{
+  return g_bytes_new (gsf_output_memory_get_bytes (GSF_OUTPUT_MEMORY (output)),
+                      gsf_output_size (output));
+}
+
+/* a distribution document keeps its sections encrypted in ViewText */
+static GBytes *build_hwp5 (gboolean is_compress, gboolean is_distribute)
+{
+  GsfOutput  *output = gsf_output_memory_new ();
+  GsfOutfile *ole    = gsf_outfile_msole_new (output);
+  GsfOutfile *body;
+  GByteArray *records;
+  guint8      header[256] = "HWP Document File";
+  GBytes     *bytes;
+
+  /* 5.0.0.0 */
+  header[35] = 5;
+  GSF_LE_SET_GUINT32 (header + 36, (is_compress ? 1 : 0) |
+                                    (is_distribute ? 1 << 2 : 0));
+  write_child (ole, "FileHeader", header, sizeof header);
+
+  records = g_byte_array_new ();
+  append_record (records, HWP_TAG_DOCUMENT_PROPERTIES, 0, header, 26);
+  write_record_stream (ole, "DocInfo", records, is_compress, FALSE);
+
+  body = GSF_OUTFILE (gsf_outfile_new_child (ole, is_distribute ? "ViewText"
+                                                                : "BodyText",
+                                             TRUE));
+
+  for (guint i = 0; i < N_SECTIONS; i++)
+  {
+    gchar name[32];
+
+    g_byte_array_set_size (records, 0);
+
+    for (guint j = 0; j < N_PARAGRAPHS; j++)
+    {
+      gchar *text = g_strdup_printf ("section %u paragraph %u", i, j);
+      append_paragraph (records, 0, text);
+      g_free (text);
+
+      if (j % TABLE_EVERY == 0)
+        append_table (records);
+    }
+
+    g_snprintf (name, sizeof name, "Section%u", i);
+    write_record_stream (body, name, records, is_compress, is_distribute);
+  }
+
+  gsf_output_close (GSF_OUTPUT (body));
+  g_object_unref (body);
+  g_byte_array_unref (records);
+
+  write_child (ole, "\005HwpSummaryInformation", header, 48);
+  write_child (ole, "PrvText", (const guint8 *) "p\0", 2);
+  write_child (ole, "PrvImage", header, 16);
+
+  gsf_output_close (GSF_OUTPUT (ole));
+  g_object_unref (ole);
+
+  bytes = steal_output_memory (output);
+  g_object_unref (output);
+
+  return bytes;
+}
+
+static GBytes *build_hwpml (void)
+{
+  GString *xml = g_string_new ("<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+                               "<HWPML Version=\"2.8\"><HEAD/><BODY>");
+
+  for (guint i = 0; i < N_SECTIONS; i++)
+  {
+    g_string_append_printf (xml, "<SECTION Id=\"%u\">", i);
+
+    for (guint j = 0; j < N_PARAGRAPHS; j++)
+      g_string_append_printf (xml, "<P><TEXT><CHAR>section %u paragraph %u"
+                                   "</CHAR></TEXT></P>", i, j);
+
+    g_string_append (xml, "</SECTION>");
+  }
+
+  g_string_append (xml, "</BODY><TAIL/></HWPML>");
+
+  return g_string_free_to_bytes (xml);
+}
+
+static GBytes *build_hwpx (void)
+{
+  GsfOutput  *output = gsf_output_memory_new ();
+  GsfOutfile *zip;
+  GsfOutfile *contents;
+  GsfOutput  *child;
+  GBytes     *bytes;
+
+  zip = g_object_new (GSF_OUTFILE_ZIP_TYPE, "sink", output, "zip64", FALSE,
+                      NULL);
+
+  /* stored first, so that the media type can be sniffed */
+  child = gsf_outfile_new_child_full (zip, "mimetype", FALSE,
+                                      "compression-level", GSF_ZIP_STORED,
+                                      NULL);
+  gsf_output_puts (child, "application/hwp+zip");
+  gsf_output_close (child);
+  g_object_unref (child);
+
+  contents = GSF_OUTFILE (gsf_outfile_new_child (zip, "Contents", TRUE));
+
+  for (guint i = 0; i < N_SECTIONS; i++)
+  {
+    gchar    name[32];
+    GString *xml = g_string_new (
+      "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+      "<hs:sec xmlns:hs=\"http://www.hancom.co.kr/hwpml/2011/section\""
+      " xmlns:hp=\"http://www.hancom.co.kr/hwpml/2011/paragraph\">");
+
+    for (guint j = 0; j < N_PARAGRAPHS; j++)
+      g_string_append_printf (xml, "<hp:p><hp:run charPrIDRef=\"0\">"
+                                   "<hp:t>section %u paragraph %u</hp:t>"
+                                   "</hp:run></hp:p>", i, j);
+
+    g_string_append (xml, "</hs:sec>");
+
+    g_snprintf (name, sizeof name, "section%u.xml", i);
+    write_child (contents, name, (const guint8 *) xml->str, xml->len);
+    g_string_free (xml, TRUE);
+  }
+
+  gsf_output_close (GSF_OUTPUT (contents));
+  g_object_unref (contents);
+
+  gsf_output_close (GSF_OUTPUT (zip));
+  g_object_unref (zip);
+
+  bytes = steal_output_memory (output);
+  g_object_unref (output);
+
+  return bytes;
+}
+
+/* HWP3 has no sections: the same paragraphs, in one compressed list */
+static GBytes *build_hwp3 (void)
+{
+  GByteArray *array           = g_byte_array_new ();
+  GByteArray *body            = g_byte_array_new ();
+  guint8      doc_info[128]   = { 0 };
+  guint8      summary[1008]   = { 0 };
+  guint8      para_info[43]   = { 0 };
+  guint8      para_shape[187] = { 0 };
+  GBytes     *bytes;
+  gsize       len;
+
+  g_byte_array_append (array,
+                       (const guint8 *) "HWP Document File V3.00 \x1a\1\2\3\4\5",
+                       30);
+  doc_info[124] = 1; /* 압축 */
+  g_byte_array_append (array, doc_info, sizeof doc_info);
+  g_byte_array_append (array, summary, sizeof summary);
+
+  /* 글꼴 이름 7 개 언어, 스타일 모두 0 개 */
+  for (guint i = 0; i < 7; i++)
+    append_uint16 (body, 0);
+  append_uint16 (body, 0);
+
+  for (guint i = 0; i < N_SECTIONS; i++)
+  {
+    for (guint j = 0; j < N_PARAGRAPHS; j++)
+    {
+      gchar *text    = g_strdup_printf ("section %u paragraph %u", i, j);
+      guint  n_chars = strlen (text);
+
+      /* 앞 문단 모양을 쓰지 않으므로 문단 모양이 따라온다; 줄 정보와
+       * 글자 모양은 없다.  글자들은 13 으로 끝난다 */
+      GSF_LE_SET_GUINT16 (para_info + 1, n_chars + 1);
+      g_byte_array_append (body, para_info, sizeof para_info);
+      g_byte_array_append (body, para_shape, sizeof para_shape);
+
+      for (guint k = 0; k < n_chars; k++)
+        append_uint16 (body, (guint8) text[k]);
+      append_uint16 (body, 13);
+
+      g_free (text);
+    }
+  }
+
+  /* 빈 문단으로 문단 리스트가 끝난다 */
+  GSF_LE_SET_GUINT16 (para_info + 1, 0);
+  g_byte_array_append (body, para_info, sizeof para_info);
+
+  bytes = deflate_raw (body);
+  g_byte_array_append (array, g_bytes_get_data (bytes, &len), len);
+  g_bytes_unref (bytes);
+  g_byte_array_unref (body);
+
+  return g_byte_array_free_to_bytes (array);
+}
+
+static void add_document (const gchar *name, GBytes *bytes)
+{
+  Document *document = g_new0 (Document, 1);
+
+  document->name  = name;
+  document->bytes = bytes;
+  g_ptr_array_add (documents, document);
+}
+
+/* parsing ******************************************************************/
+
+static gint compare_strings (gconstpointer a, gconstpointer b)
+{
+  return strcmp (*(const gchar **) a, *(const gchar **) b);
+}
+
+/* joins @texts into one string, sorted with @sort; @texts is left as is */
+static gchar *join_texts (GPtrArray *texts, gboolean sort)
+{
+  GPtrArray *copy = g_ptr_array_sized_new (texts->len + 1);
+  gchar     *retval;
+
+  for (guint i = 0; i < texts->len; i++)
+    g_ptr_array_add (copy, g_ptr_array_index (texts, i));
+
+  if (sort)
+    g_ptr_array_sort (copy, compare_strings);
+
+  g_ptr_array_add (copy, NULL);
+  retval = g_strjoinv ("\n", (gchar **) copy->pdata);
+  g_ptr_array_unref (copy);
+
+  return retval;
+}
+
+/* what parse_document () must report for the generated HWP5 documents:
+ * the body paragraphs in document order, and nothing from inside the
+ * tables */
+static gchar *generated_paragraphs (void)
+{
+  GPtrArray *texts = g_ptr_array_new_with_free_func (g_free);
+  gchar     *retval;
+
+  for (guint i = 0; i < N_SECTIONS; i++)
+    for (guint j = 0; j < N_PARAGRAPHS; j++)
+      g_ptr_array_add (texts,
+                       g_strdup_printf ("%u:section %u paragraph %u", i, i, j));
+
+  retval = join_texts (texts, FALSE);
+  g_ptr_array_unref (texts);
+
+  return retval;
+}
+
+/* the paragraph texts reported by one parse, in the order reported */
+static GPtrArray *parse_document (Document      *document,
+                                  HwpParseFlags  flags,
+                                  GError       **error)
+{
+  TestCollector *collector;
+  HwpParser     *parser;
+  HwpFile       *file;
+  GPtrArray     *retval = NULL;
+
+  if (!(file = hwp_file_new_for_bytes (document->bytes, error)))
+    return NULL;
+
+  collector = g_object_new (TEST_TYPE_COLLECTOR, NULL);
+  parser    = hwp_parser_new (HWP_LISTENABLE (collector), NULL);
+  hwp_parser_set_flags (parser, flags);
+  hwp_parser_parse (parser, file, error);
+
+  if (!*error)
+    retval = g_ptr_array_ref (collector->texts);
+
+  g_object_unref (parser);
+  g_object_unref (collector);
+  g_object_unref (file);
+
+  return retval;
+}
+
+/* every mode must report the paragraphs in document order, except
+ * HWP_PARSE_FLAGS_UNORDERED, which may report sections in any order */
+static void check (Document *document, HwpParseFlags flags)
+{
+  GError    *error = NULL;
+  GPtrArray *texts = parse_document (document, flags, &error);
+  gboolean   unordered = (flags & HWP_PARSE_FLAGS_UNORDERED) != 0;
+  gchar     *text;
+  gchar     *expected;
+
+  if (error)
+  {
+    g_printerr ("%s, flags 0x%x: %s\n", document->name, flags,
+                error->message);
+    g_atomic_int_inc (&n_failures);
+    g_clear_error (&error);
+    return;
+  }
+
+  text     = join_texts (texts, unordered);
+  expected = unordered ? document->expected_sorted : document->expected;
+
+  if (flags & HWP_PARSE_FLAGS_METADATA_ONLY ? *text != '\0'
+                                            : strcmp (text, expected))
+  {
+    g_printerr ("%s, flags 0x%x: unexpected paragraphs\n",
+                document->name, flags);
+    g_atomic_int_inc (&n_failures);
+  }
+
+  g_free (text);
+  g_ptr_array_unref (texts);
+}
+
+static gpointer parse_thread (gpointer data)
+{
+  guint n = GPOINTER_TO_UINT (data);
+
+  for (guint round = 0; round < N_ROUNDS; round++)
+  {
+    /* 스레드마다 다른 순서로 돌아서 같은 문서가 동시에 여러 모드로 읽힌다 */
+    for (guint i = 0; i < documents->len; i++)
+    {
+      Document *document = g_ptr_array_index (documents,
+                                              (i + n) % documents->len);
+
+      for (guint j = 0; j < G_N_ELEMENTS (parse_flags); j++)
+        check (document, parse_flags[(j + n + round) % G_N_ELEMENTS (parse_flags)]);
+    }
+  }
+
+  return NULL;
+}
+
+int main (int argc, char *argv[])
+{
+  GThread *threads[N_THREADS];
+  GError  *error = NULL;
+  gchar   *generated;
+  guint    n_generated;
+
+#if (!GLIB_CHECK_VERSION(2, 35, 0))
+  g_type_init();
+#endif
+
+  documents = g_ptr_array_new ();
+  add_document ("hwp5",              build_hwp5 (FALSE, FALSE));
+  add_document ("hwp5 compressed",   build_hwp5 (TRUE,  FALSE));
+  add_document ("hwp5 distribution", build_hwp5 (TRUE,  TRUE));
+  add_document ("hwpml",             build_hwpml ());
+  add_document ("hwpx",              build_hwpx ());
+  add_document ("hwp3",              build_hwp3 ());
+  n_generated = documents->len;
+
+  for (int i = 1; i < argc; i++)
+  {
+    gchar *contents;
+    gsize  len;
+
+    if (!g_file_get_contents (argv[i], &contents, &len, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return 1;
+    }
+
+    add_document (argv[i], g_bytes_new_take (contents, len));
+  }
+
+  /* 기준: 주 스레드에서 플래그 없이 읽은 결과 */
+  generated = generated_paragraphs ();
+
+  for (guint i = 0; i < documents->len; i++)
+  {
+    Document  *document = g_ptr_array_index (documents, i);
+    GPtrArray *texts    = parse_document (document, HWP_PARSE_FLAGS_NONE,
+                                          &error);
+    if (!texts)
+    {
+      g_printerr ("%s: %s\n", document->name, error->message);
+      return 1;
+    }
+
+    document->expected        = join_texts (texts, FALSE);
+    document->expected_sorted = join_texts (texts, TRUE);
+    g_ptr_array_unref (texts);
+
+    /* the generated documents must really have been read */
+    if (i < n_generated && !strstr (document->expected, "section 3 paragraph 63"))
+    {
+      g_printerr ("%s: paragraphs missing\n", document->name);
+      return 1;
+    }
+
+    /* 표 안으로 들어가지 않고 건너뛰었는지 본다 (HWP5 문서들) */
+    if (i < 3 && strcmp (document->expected, generated))
+    {
+      g_printerr ("%s: unexpected paragraphs\n", document->name);
+      return 1;
+    }
+  }
+
+  g_free (generated);
+
+  for (guint i = 0; i < N_THREADS; i++)
+    threads[i] = g_thread_new ("parse", parse_thread, GUINT_TO_POINTER (i));
+
+  for (guint i = 0; i < N_THREADS; i++)
+    g_thread_join (threads[i]);
+
+  for (guint i = 0; i < documents->len; i++)
+  {
+    Document *document = g_ptr_array_index (documents, i);
+
+    g_bytes_unref (document->bytes);
+    g_free (document->expected);
+    g_free (document->expected_sorted);
+    g_free (document);
+  }
+
+  g_ptr_array_unref (documents);
+
+  return n_failures ? 1 : 0;
+}
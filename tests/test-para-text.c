@@ -0,0 +1,277 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 2; tab-width: 2 -*- */
+/*
+ * test-para-text.c
+ * This file is part of the libhwp project.
+ *
+ * Copyright (C) 2016 Hodong Kim <cogniti@gmail.com>
+ *
+ * The libhwp is dual licensed under the LGPL v3+ or Apache License 2.0
+ *
+ * The libhwp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The libhwp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program;  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Or,
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Checks that the SSE2 and AVX2 converters of HWP_TAG_PARA_TEXT produce
+ * exactly what the scalar one does, on every path the CPU supports: ASCII,
+ * Hangul and mixed-width text with HyPUA code points, surrogate pairs,
+ * lone surrogates and control codes placed around the 8 and 16 code unit
+ * boundaries of the SIMD loops.
+ *
+ * The converters are static and _hwp_ symbols are not exported from
+ * libhwp, so hwp-para-text.c is built into the test.
+ */
+
+#include "hwp-para-text.c"
+
+#define MAX_UNITS 80
+#define N_RANDOM  16
+
+typedef struct
+{
+  const gchar *name;
+  BulkFunc     func;
+} Path;
+
+static Path  paths[3];
+static guint n_paths;
+static gint  n_failures;
+
+static const guint16 ascii[]  = { 0x20, 'a', 'Z', '0', '~', 0x7f };
+static const guint16 hangul[] = { 0xac00, 0xae00, 0xd55c, 0xd7a3 };
+/* 1, 2 and 3 bytes, with the edges of the special ranges */
+static const guint16 mixed[]  = { 'a', 0x80, 0xe9, 0x3b1, 0x7ff, 0x800,
+                                  0x4e00, 0xac00, 0xd7ff, 0xe000, 0xe0bb,
+                                  0xf8f8, 0xfffd, 0xffff };
+static const guint16 hypua[]  = { 0xe0bc, 0xe0bd, 0xf000, 0xf8f7 };
+static const guint16 lone[]   = { 0xd800, 0xdbff, 0xdc00, 0xdfff };
+/* single unit controls, a tab and extended controls of eight units */
+static const guint16 ctrl[]   = { 0, 10, 13, 24, 31, 9, 1, 11 };
+
+typedef enum
+{
+  TEXT_ASCII,
+  TEXT_HANGUL,
+  TEXT_MIXED,
+  N_TEXTS
+} Text;
+
+typedef enum
+{
+  SPECIAL_HYPUA,
+  SPECIAL_PAIR,
+  SPECIAL_LONE,
+  SPECIAL_CTRL,
+  N_SPECIALS
+} Special;
+
+static const gchar *text_names[N_TEXTS] = { "ascii", "hangul", "mixed" };
+
+#define PICK(rand, array) \
+  ((array)[g_rand_int_range ((rand), 0, G_N_ELEMENTS (array))])
+
+static void add_paths (void)
+{
+  paths[n_paths].name   = "scalar";
+  paths[n_paths++].func = bulk_scalar;
+
+#ifdef HWP_HAVE_X86_SIMD
+  __builtin_cpu_init ();
+
+  if (__builtin_cpu_supports ("sse2"))
+  {
+    paths[n_paths].name   = "sse2";
+    paths[n_paths++].func = bulk_sse2;
+  }
+
+  if (__builtin_cpu_supports ("avx2"))
+  {
+    paths[n_paths].name   = "avx2";
+    paths[n_paths++].func = bulk_avx2;
+  }
+#endif
+}
+
+static guint16 ordinary_unit (GRand *rand, Text text)
+{
+  switch (text)
+  {
+    case TEXT_ASCII:
+      return PICK (rand, ascii);
+    case TEXT_HANGUL:
+      return PICK (rand, hangul);
+    default:
+      return PICK (rand, mixed);
+  }
+}
+
+/* puts a special at @units[@i]; a surrogate pair takes two units, or is
+ * cut to a lone high surrogate at the end */
+static void put_special (guint16 *units,
+                         gsize    i,
+                         gsize    n_units,
+                         GRand   *rand,
+                         Special  special)
+{
+  switch (special)
+  {
+    case SPECIAL_HYPUA:
+      units[i] = PICK (rand, hypua);
+      break;
+    case SPECIAL_PAIR:
+      units[i] = g_rand_int_range (rand, 0xd800, 0xdc00);
+      if (i + 1 < n_units)
+        units[i + 1] = g_rand_int_range (rand, 0xdc00, 0xe000);
+      break;
+    case SPECIAL_LONE:
+      units[i] = PICK (rand, lone);
+      break;
+    default:
+      units[i] = PICK (rand, ctrl);
+      break;
+  }
+}
+
+/* runs @units through every path and compares with the scalar one, both
+ * a single bulk pass and the whole decoding loop */
+static void check_units (const guint16 *units,
+                         gsize          n_units,
+                         const gchar   *what)
+{
+  /* 정렬되지 않은 주소에서 읽는다 */
+  guint8  raw[2 * MAX_UNITS + 1];
+  guint8 *data = raw + 1;
+  guint8  expected_out[3 * MAX_UNITS + 32];
+  guint8  out[3 * MAX_UNITS + 32];
+  gsize   expected_n = 0;
+  gchar  *expected   = NULL;
+
+  for (gsize i = 0; i < n_units; i++)
+    GSF_LE_SET_GUINT16 (data + 2 * i, units[i]);
+
+  for (guint k = 0; k < n_paths; k++)
+  {
+    GString *string = g_string_new ("");
+    guint8  *p      = out;
+    gsize    n;
+
+    memset (out, 0xaa, sizeof out);
+    n = paths[k].func (&p, data, n_units);
+    para_text_append (string, data, n_units, paths[k].func);
+
+    if (k == 0)
+    {
+      memcpy (expected_out, out, sizeof out);
+      expected_n = n;
+      expected   = g_string_free (string, FALSE);
+
+      if (!g_utf8_validate (expected, -1, NULL))
+      {
+        g_printerr ("%s, %" G_GSIZE_FORMAT " units: invalid UTF-8\n",
+                    what, n_units);
+        n_failures++;
+      }
+
+      continue;
+    }
+
+    if (n != expected_n || memcmp (out, expected_out, sizeof out) ||
+        strcmp (string->str, expected))
+    {
+      g_printerr ("%s, %" G_GSIZE_FORMAT " units: %s differs from scalar\n",
+                  what, n_units, paths[k].name);
+      n_failures++;
+    }
+
+    g_string_free (string, TRUE);
+  }
+
+  g_free (expected);
+}
+
+int main (int argc, char *argv[])
+{
+  GRand   *rand = g_rand_new_with_seed (20160601);
+  guint16  units[MAX_UNITS];
+  gchar    what[64];
+
+  add_paths ();
+
+  for (gsize n_units = 0; n_units <= MAX_UNITS; n_units++)
+  {
+    for (Text text = 0; text < N_TEXTS; text++)
+    {
+      /* 보통 글자만 */
+      for (guint r = 0; r < N_RANDOM; r++)
+      {
+        for (gsize i = 0; i < n_units; i++)
+          units[i] = ordinary_unit (rand, text);
+
+        check_units (units, n_units, text_names[text]);
+      }
+
+      /* 특수 문자 하나를 모든 위치에 */
+      for (Special special = 0; special < N_SPECIALS; special++)
+      {
+        for (gsize at = 0; at < n_units; at++)
+        {
+          for (gsize i = 0; i < n_units; i++)
+            units[i] = ordinary_unit (rand, text);
+
+          put_special (units, at, n_units, rand, special);
+
+          g_snprintf (what, sizeof what, "%s, special %d at %" G_GSIZE_FORMAT,
+                      text_names[text], special, at);
+          check_units (units, n_units, what);
+        }
+      }
+
+      /* 특수 문자가 섞인 글 */
+      for (guint r = 0; r < N_RANDOM; r++)
+      {
+        for (gsize i = 0; i < n_units; i++)
+          units[i] = ordinary_unit (rand, text);
+
+        for (gsize i = 0; i < n_units; i++)
+          if (g_rand_int_range (rand, 0, 8) == 0)
+            put_special (units, i, n_units, rand,
+                         g_rand_int_range (rand, 0, N_SPECIALS));
+
+        g_snprintf (what, sizeof what, "%s with specials", text_names[text]);
+        check_units (units, n_units, what);
+      }
+    }
+  }
+
+  g_rand_free (rand);
+
+  for (guint k = 0; k < n_paths; k++)
+    g_print ("%s ", paths[k].name);
+  g_print ("checked\n");
+
+  return n_failures ? 1 : 0;
+}
@@ -142,9 +142,16 @@ void on_paragraph (HwpListenable *listenable,
   }
 }
 
+/* only the text of the paragraphs is written out */
+static HwpEventMask get_event_mask (HwpListenable *listenable)
+{
+  return HWP_EVENT_PARAGRAPHS;
+}
+
 static void hwp_to_txt_iface_init (HwpListenableInterface *iface)
 {
-  iface->paragraph = on_paragraph;
+  iface->paragraph      = on_paragraph;
+  iface->get_event_mask = get_event_mask;
 }
 
 int main (int argc, char *argv[])